@@ -0,0 +1,182 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <sstream>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "sparse_matrix.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "petsc_matrix.h"
+
+#include "assemble.h"
+
+// Parameter-affine form of the stiffness matrix.
+//
+// The stiffness matrix and the Dirichlet lift are affine in dt and
+// dt*DELTA,
+//
+//   K(dt,DELTA) = K0 + dt*K1 + dt*DELTA*K2
+//
+// K0: elasticity, div u coupling and the unit diagonal of the constrained
+//     rows, K1: Darcy mass (1/KPERM) and the grad p couplings, K2: the
+//     pressure jump stabilisation.
+//
+// The components are found once from three assemblies, K0 = K(0,0),
+// K1 = K(1,0)-K(0,0) and K2 = K(1,1)-K(1,0), and every new dt is then a
+// copy and two MatAXPY on the same nonzero pattern instead of a pass
+// over the mesh.  KPERM, E and NU are compile time constants here, so
+// they stay inside the components.
+
+const unsigned int n_affine_operators = 3;
+
+
+// The matrices of component k
+SparseMatrix<Number>& affine_stiffness (TransientLinearImplicitSystem& system, const unsigned int k)
+{
+  std::ostringstream name;
+  name << "affine_stiffness_" << k;
+  return system.get_matrix(name.str());
+}
+
+SparseMatrix<Number>& affine_lift (TransientLinearImplicitSystem& system, const unsigned int k)
+{
+  std::ostringstream name;
+  name << "affine_lift_" << k;
+  return system.get_matrix(name.str());
+}
+
+
+// Before init
+void add_affine_operators (LinearImplicitSystem& system)
+{
+  for (unsigned int k=0; k<n_affine_operators; k++)
+  {
+    std::ostringstream name;
+    name << k;
+    system.add_matrix ("affine_stiffness_" + name.str());
+    system.add_matrix ("affine_lift_" + name.str());
+  }
+}
+
+
+// Y = X, SAME_NONZERO_PATTERN needs the pattern of X in Y already
+void affine_copy (SparseMatrix<Number>& Y, SparseMatrix<Number>& X, MatStructure structure)
+{
+  PetscMatrix<Number>* petsc_Y = dynamic_cast<PetscMatrix<Number>*>(&Y);
+  PetscMatrix<Number>* petsc_X = dynamic_cast<PetscMatrix<Number>*>(&X);
+  libmesh_assert (petsc_Y != NULL);
+  libmesh_assert (petsc_X != NULL);
+
+  int ierr = MatCopy(petsc_X->mat(), petsc_Y->mat(), structure);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+}
+
+
+// Y += a*X, all components share the pattern of the stiffness assembly
+void affine_add (SparseMatrix<Number>& Y, const Real a, SparseMatrix<Number>& X)
+{
+  PetscMatrix<Number>* petsc_Y = dynamic_cast<PetscMatrix<Number>*>(&Y);
+  PetscMatrix<Number>* petsc_X = dynamic_cast<PetscMatrix<Number>*>(&X);
+  libmesh_assert (petsc_Y != NULL);
+  libmesh_assert (petsc_X != NULL);
+
+  int ierr = MatAXPY(petsc_Y->mat(), a, petsc_X->mat(), SAME_NONZERO_PATTERN);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+}
+
+
+void assemble_affine_operators (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const Real dt = es.parameters.get<Real>("dt");
+  const Real DELTA = es.parameters.get<Real>("DELTA");
+  SparseMatrix<Number>* matrix = system.matrix;
+  SparseMatrix<Number>* lift = boundary_dofs.lift;
+
+  // (dt, DELTA) of the three assemblies
+  const Real sample_dt[n_affine_operators] = {0., 1., 1.};
+  const Real sample_DELTA[n_affine_operators] = {0., 0., 1.};
+
+  for (unsigned int k=0; k<n_affine_operators; k++)
+  {
+    es.parameters.set<Real>("dt") = sample_dt[k];
+    es.parameters.set<Real>("DELTA") = sample_DELTA[k];
+    system.matrix = &affine_stiffness(system,k);
+    boundary_dofs.lift = &affine_lift(system,k);
+    system.matrix->zero();
+    assemble_stiffness(es,system_name);
+  }
+
+  system.matrix = matrix;
+  boundary_dofs.lift = lift;
+  es.parameters.set<Real>("dt") = dt;
+  es.parameters.set<Real>("DELTA") = DELTA;
+
+  // Differences, from the last one so that every sample is still there
+  for (unsigned int k=n_affine_operators-1; k>0; k--)
+  {
+    affine_add(affine_stiffness(system,k), -1., affine_stiffness(system,k-1));
+    affine_add(affine_lift(system,k), -1., affine_lift(system,k-1));
+  }
+
+  // The matrices formed from the components get their nonzero pattern
+  affine_copy(*system.matrix, affine_stiffness(system,0), DIFFERENT_NONZERO_PATTERN);
+  affine_copy(*boundary_dofs.lift, affine_lift(system,0), DIFFERENT_NONZERO_PATTERN);
+  if (es.parameters.get<unsigned int>("parareal_slices") > 0)
+  {
+    affine_copy(system.get_matrix("coarse_stiffness"), affine_stiffness(system,0), DIFFERENT_NONZERO_PATTERN);
+    affine_copy(system.get_matrix("coarse_dirichlet_lift"), affine_lift(system,0), DIFFERENT_NONZERO_PATTERN);
+  }
+
+  std::cout<<"Affine operators assembled"<<std::endl;
+}
+
+
+// system.matrix and boundary_dofs.lift for the current dt and DELTA
+void combine_affine_operators (EquationSystems& es,
+                      const std::string& system_name)
+{
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> (system_name);
+
+  const Real dt = es.parameters.get<Real>("dt");
+  const Real coefficient[n_affine_operators] = {1., dt, dt*es.parameters.get<Real>("DELTA")};
+
+  affine_copy(*system.matrix, affine_stiffness(system,0), SAME_NONZERO_PATTERN);
+  affine_copy(*boundary_dofs.lift, affine_lift(system,0), SAME_NONZERO_PATTERN);
+  for (unsigned int k=1; k<n_affine_operators; k++)
+  {
+    affine_add(*system.matrix, coefficient[k], affine_stiffness(system,k));
+    affine_add(*boundary_dofs.lift, coefficient[k], affine_lift(system,k));
+  }
+}
+
+
+// New stiffness matrix (and lift) for the current dt, assembled or
+// combined from the affine components
+void update_stiffness (EquationSystems& es,
+                      const std::string& system_name)
+{
+  if (es.parameters.get<bool>("affine_operators"))
+  {
+    combine_affine_operators(es,system_name);
+    return;
+  }
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> (system_name);
+  system.matrix->zero();
+  assemble_stiffness(es,system_name);
+}
@@ -62,6 +62,8 @@
 #define ELEMENT_TYPE_PRESS MONOMIAL
 #define MESH_ELEMENT TRI3
 #define USE_STAB 1
+//Order of the MONOMIAL space of -error_norms projection
+#define ERROR_ORDER SECOND
 
 
 #define E 1
@@ -78,10 +80,66 @@
 #define ELEMENT_TYPE LAGRANGE
 #define ELEMENT_TYPE_PRESS LAGRANGE
 #define MESH_ELEMENT TRI6
+#define ERROR_ORDER THIRD
 */
 
 using namespace libMesh;
 
+// Dirichlet rows found once by build_boundary_dofs, the values are
+// refreshed every step by update_boundary_values
+struct BoundaryDofs
+{
+  std::vector<int> rows;
+  std::vector<const Node*> nodes;
+  std::vector<unsigned int> vars;
+  std::vector<Real> values;
+
+  std::vector<int> pressure_rows;
+  std::vector<const Node*> pressure_nodes;
+  std::vector<Real> pressure_values;
+
+  // All constrained dofs of the mesh, indexed by global dof
+  std::vector<bool> constrained;
+
+  // The stiffness columns of the constrained dofs, assembled together
+  // with the stiffness matrix
+  SparseMatrix<Number>* lift;
+};
+
+extern BoundaryDofs boundary_dofs;
+
+void build_boundary_dofs (EquationSystems& es,
+                      const std::string& system_name);
+
+void update_boundary_values (EquationSystems& es,
+                      const std::string& system_name);
+
+void constrain_element_matrix (DenseMatrix<Number>& Ke, DenseMatrix<Number>& Le,
+                      const std::vector<unsigned int>& row_dofs, const std::vector<unsigned int>& col_dofs);
+
+void constrain_element_vector (DenseVector<Number>& Fe,
+                      const std::vector<unsigned int>& dof_indices);
+
+void add_dirichlet_lift (EquationSystems& es,
+                      const std::string& system_name);
+
+void build_pressure_jumps (EquationSystems& es,
+                      const std::string& system_name);
+
+void assemble_pressure_jumps (EquationSystems& es,
+                      const std::string& system_name);
+
+void add_affine_operators (LinearImplicitSystem& system);
+
+void assemble_affine_operators (EquationSystems& es,
+                      const std::string& system_name);
+
+void combine_affine_operators (EquationSystems& es,
+                      const std::string& system_name);
+
+void update_stiffness (EquationSystems& es,
+                      const std::string& system_name);
+
 
 void assemble_stiffness (EquationSystems& es,
                       const std::string& system_name);
@@ -92,10 +150,63 @@ void assemble_rhs (EquationSystems& es,
 
 void read_parameters(EquationSystems& es, int& argc, char**& argv) ;
 
+std::vector<Real> read_sweep_values (const std::string& option);
+
+void open_output (EquationSystems& es, const std::string& file_name);
+
+void write_output (EquationSystems& es, const unsigned int step, const Real time);
+
+void close_output ();
+
+void setup_problem (Mesh& mesh, EquationSystems& equation_systems);
+
+void solve_problem (Mesh& mesh, EquationSystems& equation_systems, std::vector<Real>& errors);
+
+void advance_time_step (EquationSystems& es,
+                      const std::string& system_name);
+
+Real estimate_time_error (EquationSystems& es,
+                      const std::string& system_name, const Real dt, const Real dt_old);
+
+void assemble_history (EquationSystems& es,
+                      const std::string& system_name, SparseMatrix<Number>& history);
+
+void space_time_solve (EquationSystems& es, const std::string& system_name,
+                      std::vector<NumericVector<Number>*>& solutions);
+
+void parareal_solve (EquationSystems& es, const std::string& system_name,
+                      std::vector<NumericVector<Number>*>& solutions);
+
+MPI_Comm parareal_split_world (int& argc, char**& argv);
+
+unsigned int parareal_group ();
+
+void compute_block_scaling (EquationSystems& es,
+                      const std::string& system_name);
+
+void apply_block_scaling (EquationSystems& es,
+                      const std::string& system_name);
+
+void remove_block_scaling (EquationSystems& es,
+                      const std::string& system_name);
+
 
 void assemble_stokes (EquationSystems& es,
                       const std::string& system_name);
 
+void build_error_cache (EquationSystems& es,
+                      const std::string& system_name);
+
+void add_error_projection (EquationSystems& es);
+
+void build_error_projection (EquationSystems& es,
+                      const std::string& system_name);
+
+void clear_error_caches ();
+
+void projected_error (Real& H1_semi_error_disp, Real& Hdiv_semi_error_vel, Real& L2_error_press, Real& L2_error_displacement, Real& L2_error_velocity, EquationSystems& es,
+                      const std::string& system_name);
+
 void assemble_error(Real& H1_semi_error_disp, Real& Hdiv_semi_error_vel, Real& L2_error_press,Real& L2_error_displacement,Real& L2_error_velocity,  EquationSystems& es,
                       const std::string& system_name);
 
@@ -172,4 +283,8 @@ Gradient exact_2D_derivative_p(const Point& p,
 
 Number forcing_function_2D(const Point& p, const Parameters& parameters);
 
+Real exact_2D_time_factor(const Real t);
+
+Real exact_2D_reference_time();
+
 #endif 
@@ -31,329 +31,325 @@
 // The definition of a geometric element
 #include "elem.h"
 #include <fe_interface.h>
+#include "threads.h"
+#include "parallel.h"
 
 #include "assemble.h"
 
-void assemble_error (Real& H1_semi_error_disp, Real& Hdiv_semi_error_vel, Real& L2_error_press, Real& L2_error_displacement, Real& L2_error_velocity, EquationSystems& es,
-                      const std::string& system_name)
+// Error norms of the manufactured solution.
+//
+// The quadrature (EIGHTH order) geometry, the shape functions and the
+// spatial part X(x) of the exact solution X(x)*T(t) at the quadrature
+// points do not change from one step to the next, so they are computed
+// once per element by build_error_cache.  assemble_error then only
+// gathers the element dofs of the current solution and scales the
+// cached exact values by T(time).
+//
+// The elements are integrated by threads, each into its own entry of
+// element_errors, which are then summed in element order on every rank
+// and in rank order over the ranks, so the norms do not depend on the
+// number of threads and are the same on every rank.
+
+struct ErrorElement
 {
+  // Positions in error_dofs of the dofs of s_u,s_v(,s_w), x,y(,z) and s_p
+  std::vector<std::vector<unsigned int> > disp_dofs;
+  std::vector<std::vector<unsigned int> > vel_dofs;
+  std::vector<unsigned int> p_dofs;
+
+  std::vector<Real> JxW;
+
+  // Shape functions, [i][qp]
+  std::vector<std::vector<Real> > phi, f_phi, psi;
+  std::vector<std::vector<RealGradient> > dphi, f_dphi;
+
+  // X(x) of the exact solution, [var][qp]
+  std::vector<std::vector<Real> > exact_disp, exact_vel;
+  std::vector<std::vector<RealGradient> > exact_grad_disp, exact_grad_vel;
+  std::vector<Real> exact_p;
+};
+
+std::vector<ErrorElement> error_elements;
+
+// All dofs the local elements read
+std::vector<unsigned int> error_dofs;
 
-  PerfLog perf_log("Assemble");
+// L2 u, H1 semi u, L2 z, Hdiv semi z and L2 p of every element
+const unsigned int n_error_norms = 5;
+std::vector<Real> element_errors;
 
-  // It is a good idea to make sure we are assembling
-  // the proper system.
+typedef Number (*ExactValue)(const Point&, const Parameters&, const std::string&, const std::string&);
+typedef Gradient (*ExactGradient)(const Point&, const Parameters&, const std::string&, const std::string&);
+
+
+void build_error_cache (EquationSystems& es,
+                      const std::string& system_name)
+{
   libmesh_assert (system_name == "Last_non_linear_soln");
-  
-  const Real dt    = es.parameters.get<Real>("dt");
-  const Real progress    = es.parameters.get<Real>("progress");
-  const Real time    = es.parameters.get<Real>("time");
 
-  // Get a constant reference to the mesh object.
   const MeshBase& mesh = es.get_mesh();
-  
-  // The dimension that we are running
   const unsigned int dim = mesh.mesh_dimension();
-  
-  // Get a reference to the Convection-Diffusion system object.
+
   TransientLinearImplicitSystem & system =
     es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
 
- //TransientLinearImplicitSystem & system =    es.get_system<TransientLinearImplicitSystem> ("Stokes");
-  // Numeric ids corresponding to each variable in the system
-  const unsigned int u_var = system.variable_number ("s_u");
-  const unsigned int v_var = system.variable_number ("s_v");
-  #if THREED
-  const unsigned int w_var = system.variable_number ("s_w");
+  #if !THREED
+  const char* disp_names[] = {"s_u", "s_v"};
+  const char* vel_names[] = {"x", "y"};
+  const ExactValue exact_disp[] = {exact_2D_solution_u, exact_2D_solution_v};
+  const ExactValue exact_vel[] = {exact_2D_solution_x, exact_2D_solution_y};
+  const ExactGradient exact_grad_disp[] = {exact_2D_derivative_u, exact_2D_derivative_v};
+  const ExactGradient exact_grad_vel[] = {exact_2D_derivative_x, exact_2D_derivative_y};
   #endif
-  const unsigned int p_var = system.variable_number ("s_p");
-  const unsigned int x_var = system.variable_number ("x");
-  const unsigned int y_var = system.variable_number ("y");
   #if THREED
-  const unsigned int z_var = system.variable_number ("z");
+  const char* disp_names[] = {"s_u", "s_v", "s_w"};
+  const char* vel_names[] = {"x", "y", "z"};
+  const ExactValue exact_disp[] = {exact_2D_solution_u, exact_2D_solution_v, exact_2D_solution_w};
+  const ExactValue exact_vel[] = {exact_2D_solution_x, exact_2D_solution_y, exact_2D_solution_z};
+  const ExactGradient exact_grad_disp[] = {exact_2D_derivative_u, exact_2D_derivative_v, exact_2D_derivative_w};
+  const ExactGradient exact_grad_vel[] = {exact_2D_derivative_x, exact_2D_derivative_y, exact_2D_derivative_z};
   #endif
-  // Get the Finite Element type for "u".  Note this will be
-  // the same as the type for "v".
-  FEType fe_disp_type = system.variable_type(u_var);
-  FEType fe_vel_type = system.variable_type(x_var);
+  const unsigned int n_components = sizeof(disp_names)/sizeof(disp_names[0]);
+
+  const unsigned int p_var = system.variable_number ("s_p");
 
-  // Get the Finite Element type for "p".
+  FEType fe_disp_type = system.variable_type(system.variable_number(disp_names[0]));
+  FEType fe_vel_type = system.variable_type(system.variable_number(vel_names[0]));
   FEType fe_pres_type = system.variable_type(p_var);
 
-  // Build a Finite Element object of the specified type for
-  // the velocity variables.
   AutoPtr<FEBase> fe_disp  (FEBase::build(dim, fe_disp_type));
   AutoPtr<FEBase> fe_vel  (FEBase::build(dim, fe_vel_type));
-    
-  // Build a Finite Element object of the specified type for
-  // the pressure variables.
   AutoPtr<FEBase> fe_pres (FEBase::build(dim, fe_pres_type));
-  
-  // A Gauss quadrature rule for numerical integration.
-  // Let the \p FEType object decide what order rule is appropriate.
-  
-  //QGauss qrule (dim, fe_vel_type.default_quadrature_order());
 
- // QGauss qrule (dim, SIXTEENTH);
-    QGauss qrule (dim, EIGHTH);
-
-// QGauss qrule (dim, CONSTANT);
-
-  // Tell the finite element objects to use our quadrature rule.
+  QGauss qrule (dim, EIGHTH);
   fe_disp->attach_quadrature_rule (&qrule);
   fe_vel->attach_quadrature_rule (&qrule);
   fe_pres->attach_quadrature_rule (&qrule);
-  
-  // Here we define some references to cell-specific data that
-  // will be used to assemble the linear system.
-  //
-  // The element Jacobian * quadrature weight at each integration point.   
+
   const std::vector<Real>& JxW = fe_vel->get_JxW();
-  
   const std::vector<Point>& q_point = fe_vel->get_xyz();
-  const std::vector<Point>& q_point_p = fe_pres->get_xyz();
-
-  // The element shape function gradients for the velocity
-  // variables evaluated at the quadrature points.
   const std::vector<std::vector<RealGradient> >& dphi = fe_disp->get_dphi();
   const std::vector<std::vector<Real> >& phi = fe_disp->get_phi();
   const std::vector<std::vector<RealGradient> >& f_dphi = fe_vel->get_dphi();
   const std::vector<std::vector<Real> >& f_phi = fe_vel->get_phi();
-
-  // The element shape functions for the pressure variable
-  // evaluated at the quadrature points.
   const std::vector<std::vector<Real> >& psi = fe_pres->get_phi();
-  const std::vector<std::vector<RealGradient> >& dpsi = fe_pres->get_dphi();
 
-  // A reference to the \p DofMap object for this system.  The \p DofMap
-  // object handles the index translation from node and element numbers
-  // to degree of freedom numbers.  We will talk more about the \p DofMap
-  // in future examples.
   const DofMap & dof_map = system.get_dof_map();
 
-  // Define data structures to contain the element matrix
-  // and right-hand-side vector contribution.  Following
-  // basic finite element terminology we will denote these
-  // "Ke" and "Fe".
+  // The exact functions give X(x) at the reference time
+  const Real time = es.parameters.get<Real>("time");
+  es.parameters.set<Real>("time") = exact_2D_reference_time();
 
-
-  // This vector will hold the degree of freedom indices for
-  // the element.  These define where in the global system
-  // the element degrees of freedom get mapped.
-  std::vector<unsigned int> dof_indices;
-  std::vector<unsigned int> dof_indices_u;
-  std::vector<unsigned int> dof_indices_v;
-  #if THREED
-  std::vector<unsigned int> dof_indices_w;
-  #endif
-  std::vector<unsigned int> dof_indices_p;
-  std::vector<unsigned int> dof_indices_x;
-  std::vector<unsigned int> dof_indices_y;
-  #if THREED
-  std::vector<unsigned int> dof_indices_z;
-  #endif
-  
-  // Now we will loop over all the elements in the mesh that
-  // live on the local processor. We will compute the element
-  // matrix and right-hand-side contribution.  In case users later
-  // modify this program to include refinement, we will be safe and
-  // will only consider the active elements; hence we use a variant of
-  // the \p active_elem_iterator.
+  error_elements.clear();
+  error_elements.reserve(mesh.n_active_local_elem());
 
   MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
-  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end(); 
-  
-
-//vectors needed to store bcs. (wha happened to condense ?)
-std::vector<  int > rows;
-std::vector<  int > pressure_rows;
-std::vector< Real > rows_values;
-std::vector< Real > pressure_rows_values;
-
-std::vector< int> stab_dofs_rows;
-std::vector< int> stab_dofs_cols;
-std::vector<Real> stab_dofs_vals;
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
 
-std::vector<Real> error_disp(4);
-std::vector<Real> error_vel(4);
-std::vector<Real> error_p(4);
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+
+    error_elements.push_back(ErrorElement());
+    ErrorElement& cache = error_elements.back();
+
+    fe_disp->reinit  (elem);
+    fe_vel->reinit  (elem);
+    fe_pres->reinit (elem);
+
+    cache.disp_dofs.resize(n_components);
+    cache.vel_dofs.resize(n_components);
+    cache.exact_disp.resize(n_components);
+    cache.exact_vel.resize(n_components);
+    cache.exact_grad_disp.resize(n_components);
+    cache.exact_grad_vel.resize(n_components);
+    for (unsigned int c=0; c<n_components; c++)
+    {
+      dof_map.dof_indices (elem, cache.disp_dofs[c], system.variable_number(disp_names[c]));
+      dof_map.dof_indices (elem, cache.vel_dofs[c], system.variable_number(vel_names[c]));
+    }
+    dof_map.dof_indices (elem, cache.p_dofs, p_var);
+
+    cache.JxW = JxW;
+    cache.phi = phi;
+    cache.dphi = dphi;
+    cache.f_phi = f_phi;
+    cache.f_dphi = f_dphi;
+    cache.psi = psi;
+
+    for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+    {
+      for (unsigned int c=0; c<n_components; c++)
+      {
+        cache.exact_disp[c].push_back(exact_disp[c](q_point[qp], es.parameters,"null","void"));
+        cache.exact_vel[c].push_back(exact_vel[c](q_point[qp], es.parameters,"null","void"));
+        cache.exact_grad_disp[c].push_back(exact_grad_disp[c](q_point[qp], es.parameters,"null","void"));
+        cache.exact_grad_vel[c].push_back(exact_grad_vel[c](q_point[qp], es.parameters,"null","void"));
+      }
+      cache.exact_p.push_back(exact_2D_solution_p(q_point[qp], es.parameters,"null","void"));
+    }
+  }
+
+  es.parameters.set<Real>("time") = time;
+
+  // Dofs to positions in error_dofs
+  error_dofs.clear();
+  for (unsigned int e=0; e<error_elements.size(); e++)
+  {
+    for (unsigned int c=0; c<n_components; c++)
+    {
+      error_dofs.insert(error_dofs.end(), error_elements[e].disp_dofs[c].begin(), error_elements[e].disp_dofs[c].end());
+      error_dofs.insert(error_dofs.end(), error_elements[e].vel_dofs[c].begin(), error_elements[e].vel_dofs[c].end());
+    }
+    error_dofs.insert(error_dofs.end(), error_elements[e].p_dofs.begin(), error_elements[e].p_dofs.end());
+  }
+  std::sort(error_dofs.begin(), error_dofs.end());
+  error_dofs.erase(std::unique(error_dofs.begin(), error_dofs.end()), error_dofs.end());
+
+  for (unsigned int e=0; e<error_elements.size(); e++)
+  {
+    ErrorElement& cache = error_elements[e];
+    for (unsigned int c=0; c<n_components; c++)
+    {
+      for (unsigned int i=0; i<cache.disp_dofs[c].size(); i++)
+        cache.disp_dofs[c][i] = std::lower_bound(error_dofs.begin(), error_dofs.end(), cache.disp_dofs[c][i]) - error_dofs.begin();
+      for (unsigned int i=0; i<cache.vel_dofs[c].size(); i++)
+        cache.vel_dofs[c][i] = std::lower_bound(error_dofs.begin(), error_dofs.end(), cache.vel_dofs[c][i]) - error_dofs.begin();
+    }
+    for (unsigned int i=0; i<cache.p_dofs.size(); i++)
+      cache.p_dofs[i] = std::lower_bound(error_dofs.begin(), error_dofs.end(), cache.p_dofs[i]) - error_dofs.begin();
+  }
+
+  element_errors.resize(n_error_norms*error_elements.size());
+}
 
-//std::cout<< error_vals.size() <<std::endl;
 
-  for ( ; el != end_el; ++el)
-    {    
-
-       test(6);
-
-      // Store a pointer to the element we are currently
-      // working on.  This allows for nicer syntax later.
-      const Elem* elem = *el;
-      
-      // Get the degree of freedom indices for the
-      // current element.  These define where in the global
-      // matrix and right-hand-side this element will
-      // contribute to.
-      dof_map.dof_indices (elem, dof_indices);
-      dof_map.dof_indices (elem, dof_indices_u, u_var);
-      dof_map.dof_indices (elem, dof_indices_v, v_var);
-      #if THREED
-      dof_map.dof_indices (elem, dof_indices_w, w_var);
-      #endif
-      dof_map.dof_indices (elem, dof_indices_p, p_var);
-      dof_map.dof_indices (elem, dof_indices_x, x_var);
-      dof_map.dof_indices (elem, dof_indices_y, y_var);
-      #if THREED
-      dof_map.dof_indices (elem, dof_indices_z, z_var);
-      #endif
-
-      const unsigned int n_dofs   = dof_indices.size();
-      const unsigned int n_u_dofs = dof_indices_u.size(); 
-      const unsigned int n_v_dofs = dof_indices_v.size();
-      const unsigned int n_p_dofs = dof_indices_p.size();
-      const unsigned int n_x_dofs = dof_indices_x.size(); 
-      const unsigned int n_y_dofs = dof_indices_y.size();
-      
-      // Compute the element-specific data for the current
-      // element.  This involves computing the location of the
-      // quadrature points (q_point) and the shape functions
-      // (phi, dphi) for the current element.
-      fe_disp->reinit  (elem);
-      fe_vel->reinit  (elem);
-      fe_pres->reinit (elem);
-
-
-      // Now we will build the element matrix.
-      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+// Integrates the errors of a range of cached elements into element_errors
+class ErrorIntegrator
+{
+public:
+  ErrorIntegrator (const std::vector<Number>& values, const Real time_factor) :
+    _values(values), _time_factor(time_factor)
+  {}
+
+  void operator() (const Threads::BlockedRange<unsigned int>& range) const
+  {
+    // Element values of the current solution
+    std::vector<std::vector<Number> > disp_h, vel_h;
+    std::vector<Number> p_h;
+
+    for (unsigned int e=range.begin(); e!=range.end(); ++e)
+    {
+      const ErrorElement& cache = error_elements[e];
+      const unsigned int n_components = cache.disp_dofs.size();
+      Real* errors = &element_errors[n_error_norms*e];
+      for (unsigned int k=0; k<n_error_norms; k++)
+        errors[k] = 0.;
+
+      disp_h.resize(n_components);
+      vel_h.resize(n_components);
+      for (unsigned int c=0; c<n_components; c++)
+      {
+        disp_h[c].resize(cache.disp_dofs[c].size());
+        for (unsigned int i=0; i<cache.disp_dofs[c].size(); i++)
+          disp_h[c][i] = _values[cache.disp_dofs[c][i]];
+
+        vel_h[c].resize(cache.vel_dofs[c].size());
+        for (unsigned int i=0; i<cache.vel_dofs[c].size(); i++)
+          vel_h[c][i] = _values[cache.vel_dofs[c][i]];
+      }
+      p_h.resize(cache.p_dofs.size());
+      for (unsigned int i=0; i<cache.p_dofs.size(); i++)
+        p_h[i] = _values[cache.p_dofs[i]];
+
+      for (unsigned int qp=0; qp<cache.JxW.size(); qp++)
+      {
+        const Real JxW = cache.JxW[qp];
+        Real div_error_vel = 0.;
+
+        for (unsigned int c=0; c<n_components; c++)
         {
-
-  
-        //Displacement errors
-        Real u_h = 0.;
-        RealGradient grad_u_h;
-        Real v_h = 0.;
-        RealGradient grad_v_h;
-        #if THREED
-        Real w_h = 0.;
-        RealGradient grad_w_h;
-        #endif
-        for (unsigned int i=0; i<n_u_dofs; i++)
+          //Displacement errors
+          Real u_h = 0.;
+          RealGradient grad_u_h;
+          for (unsigned int i=0; i<disp_h[c].size(); i++)
           {
-               u_h      += phi[i][qp]*system.current_solution  (dof_indices_u[i]);
-               grad_u_h += dphi[i][qp]*system.current_solution (dof_indices_u[i]);
-               v_h      += phi[i][qp]*system.current_solution  (dof_indices_v[i]);
-               grad_v_h += dphi[i][qp]*system.current_solution (dof_indices_v[i]);   
-              #if THREED
-               w_h      += phi[i][qp]*system.current_solution  (dof_indices_w[i]);
-               grad_w_h += dphi[i][qp]*system.current_solution (dof_indices_w[i]);
-              #endif
+            u_h      += cache.phi[i][qp]*disp_h[c][i];
+            grad_u_h += cache.dphi[i][qp]*disp_h[c][i];
           }
-
-        Real exact_u = exact_2D_solution_u(q_point[qp], es.parameters,"null","void");
-        Real error_u_sq =  (pow(u_h - exact_u,2));
-        Real exact_v = exact_2D_solution_v(q_point[qp], es.parameters,"null","void");
-        Real error_v_sq = (pow(v_h - exact_v,2));
-        error_disp[0] += JxW[qp]*error_u_sq+JxW[qp]*error_v_sq;
-        #if THREED
-        Real exact_w = exact_2D_solution_w(q_point[qp], es.parameters,"null","void");
-        Real error_w_sq = (pow(w_h - exact_w,2));
-        error_disp[0] += JxW[qp]*error_w_sq;
-        #endif
-
-        RealGradient exact_gradu =exact_2D_derivative_u(q_point[qp], es.parameters,"null","void");
-        RealGradient error_grad_u = grad_u_h - exact_gradu;
-        RealGradient exact_gradv =exact_2D_derivative_v(q_point[qp], es.parameters,"null","void");
-        RealGradient error_grad_v = grad_v_h - exact_gradv;
-        error_disp[1] += JxW[qp]*error_grad_u.size_sq()+JxW[qp]*error_grad_v.size_sq();
-        #if THREED
-        RealGradient exact_gradw =exact_2D_derivative_w(q_point[qp], es.parameters,"null","void");
-        RealGradient error_grad_w = grad_w_h - exact_gradw;
-        error_disp[1] += JxW[qp]*error_grad_w.size_sq();
-        #endif
-
-      
-        //Velocity errors
-        Real x_h = 0.;
-        RealGradient grad_x_h;
-        Real y_h = 0.;
-        RealGradient grad_y_h;
-        #if THREED
-        Real z_h = 0.;
-        RealGradient grad_z_h;
-        #endif
-        for (unsigned int i=0; i<n_x_dofs; i++)
+          const RealGradient error_grad_u = grad_u_h - _time_factor*cache.exact_grad_disp[c][qp];
+          errors[0] += JxW*pow(u_h - _time_factor*cache.exact_disp[c][qp],2);
+          errors[1] += JxW*error_grad_u.size_sq();
+
+          //Velocity errors
+          Real x_h = 0.;
+          RealGradient grad_x_h;
+          for (unsigned int i=0; i<vel_h[c].size(); i++)
           {
-               x_h      += phi[i][qp]*system.current_solution  (dof_indices_x[i]);
-               grad_x_h += dphi[i][qp]*system.current_solution (dof_indices_x[i]);
-               y_h      += phi[i][qp]*system.current_solution  (dof_indices_y[i]);
-               grad_y_h += dphi[i][qp]*system.current_solution (dof_indices_y[i]);
-               #if THREED
-               z_h      += phi[i][qp]*system.current_solution  (dof_indices_z[i]);
-               grad_z_h += dphi[i][qp]*system.current_solution (dof_indices_z[i]);
-              #endif
+            x_h      += cache.f_phi[i][qp]*vel_h[c][i];
+            grad_x_h += cache.f_dphi[i][qp]*vel_h[c][i];
           }
-
-        Real exact_x = exact_2D_solution_x(q_point[qp], es.parameters,"null","void");
-        Real error_x_sq = (pow(x_h - exact_x,2));
-        Real exact_y = exact_2D_solution_y(q_point[qp], es.parameters,"null","void");
-        Real error_y_sq = (pow(y_h - exact_y,2));
-        error_vel[0] += JxW[qp]*error_x_sq+JxW[qp]*error_y_sq;
-        #if THREED
-        Real exact_z = exact_2D_solution_z(q_point[qp], es.parameters,"null","void");
-        Real error_z_sq = (pow(z_h - exact_z,2));
-        error_vel[0] += JxW[qp]*error_z_sq;
-        #endif
-
-        RealGradient exact_gradx =exact_2D_derivative_x(q_point[qp], es.parameters,"null","void");
-        RealGradient error_grad_x = grad_x_h - exact_gradx;
-        RealGradient exact_grady =exact_2D_derivative_y(q_point[qp], es.parameters,"null","void");
-        RealGradient error_grad_y = grad_y_h - exact_grady;
-        error_vel[1] += JxW[qp]*error_grad_x.size_sq()+JxW[qp]*error_grad_y.size_sq();
-        #if THREED
-        RealGradient exact_gradz =exact_2D_derivative_z(q_point[qp], es.parameters,"null","void");
-        RealGradient error_grad_z = grad_z_h - exact_gradz;
-        error_vel[1] += JxW[qp]*error_grad_z.size_sq();
-        #endif
-
-        RealGradient div_error_vel;
-        #if !THREED
-        div_error_vel(0) = grad_x_h(0) - exact_gradx(0)+grad_y_h(1) - exact_grady(1);
-        #endif
-        #if THREED
-        div_error_vel(0) = grad_x_h(0) - exact_gradx(0)+grad_y_h(1) - exact_grady(1) +grad_z_h(2) - exact_gradz(2);
-        #endif
-        error_vel[2] += JxW[qp]*div_error_vel.size_sq();
-
+          errors[2] += JxW*pow(x_h - _time_factor*cache.exact_vel[c][qp],2);
+          div_error_vel += grad_x_h(c) - _time_factor*cache.exact_grad_vel[c][qp](c);
+        }
+        errors[3] += JxW*div_error_vel*div_error_vel;
 
         //Pressure errors
-        Real p_h = 0.;
-        for (unsigned int i=0; i<n_p_dofs; i++)
-          {
-               p_h      += psi[i][qp]*system.current_solution  (dof_indices_p[i]);
-          }
-
-
-        Real exact_p = exact_2D_solution_p(q_point_p[qp], es.parameters,"null","void");
-        Real error_p_sq = (pow(p_h - exact_p,2));
-        error_p[0] += JxW[qp]*error_p_sq;
+        Real p_value = 0.;
+        for (unsigned int i=0; i<p_h.size(); i++)
+          p_value += cache.psi[i][qp]*p_h[i];
+        errors[4] += JxW*pow(p_value - _time_factor*cache.exact_p[qp],2);
+      }
+    }
+  }
 
-} // end qp
+private:
+  const std::vector<Number>& _values;
+  const Real _time_factor;
+};
 
 
+void assemble_error (Real& H1_semi_error_disp, Real& Hdiv_semi_error_vel, Real& L2_error_press, Real& L2_error_displacement, Real& L2_error_velocity, EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
 
-} // end of element loop
-  
-  H1_semi_error_disp=sqrt(error_disp[1]);
-  Hdiv_semi_error_vel=sqrt(error_vel[2]);  
-  L2_error_press=sqrt(error_p[0]);
-  L2_error_displacement=sqrt(error_disp[0]);
-  L2_error_velocity=sqrt(error_vel[0]);
-
- // std::cout<<"H1_semi_error_disp "<< H1_semi_error_disp<<std::endl;
- // std::cout<<"Hdiv_semi_error_vel "<<Hdiv_semi_error_vel<<std::endl;
-// std::cout<<"L2_error_disp "<<sqrt(error_disp[0])<<std::endl;
- //  std::cout<<"L2_error_press "<< sqrt(error_p[0])<<std::endl;
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
 
-  // That's it.
-  return;
+  if (es.parameters.get<std::string>("error_norms") == "projection")
+  {
+    projected_error(H1_semi_error_disp,Hdiv_semi_error_vel,L2_error_press,L2_error_displacement,L2_error_velocity,es,system_name);
+    return;
+  }
+
+  if (error_elements.empty())
+    build_error_cache(es,system_name);
+
+  const Real time_factor = exact_2D_time_factor(es.parameters.get<Real>("time"));
+
+  // The threads only read this copy of the current solution
+  std::vector<Number> values(error_dofs.size());
+  for (unsigned int k=0; k<error_dofs.size(); k++)
+    values[k] = system.current_solution(error_dofs[k]);
+
+  Threads::parallel_for (Threads::BlockedRange<unsigned int>(0, error_elements.size()),
+                         ErrorIntegrator(values, time_factor));
+
+  std::vector<Real> local_errors(n_error_norms, 0.);
+  for (unsigned int e=0; e<error_elements.size(); e++)
+    for (unsigned int k=0; k<n_error_norms; k++)
+      local_errors[k] += element_errors[n_error_norms*e+k];
+
+  std::vector<Real> errors(n_error_norms, 0.);
+  Parallel::allgather(local_errors);
+  for (unsigned int r=0; r<libMesh::n_processors(); r++)
+    for (unsigned int k=0; k<n_error_norms; k++)
+      errors[k] += local_errors[n_error_norms*r+k];
+
+  L2_error_displacement=sqrt(errors[0]);
+  H1_semi_error_disp=sqrt(errors[1]);
+  L2_error_velocity=sqrt(errors[2]);
+  Hdiv_semi_error_vel=sqrt(errors[3]);
+  L2_error_press=sqrt(errors[4]);
 }
-
-
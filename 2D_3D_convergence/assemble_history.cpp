@@ -0,0 +1,109 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <time.h>
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "mesh_generation.h"
+#include "exodusII_io.h"
+#include "equation_systems.h"
+#include "fe.h"
+#include "quadrature_gauss.h"
+#include "dof_map.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "dense_matrix.h"
+#include "dense_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "dense_matrix_base.h"
+#include "dense_vector_base.h"
+
+// For systems of equations the \p DenseSubMatrix
+// and \p DenseSubVector provide convenient ways for
+// assembling the element matrix and vector on a
+// component-by-component basis.
+#include "dense_submatrix.h"
+#include "dense_subvector.h"
+// The definition of a geometric element
+#include "elem.h"
+#include "assemble.h"
+
+// The history operator H of the backward Euler step: assemble_rhs adds
+// -(div u^n, psi) to the mass rows, which is H x^n with x^n the old
+// solution.  The constrained rows do not depend on the history and are
+// zero in H.
+void assemble_history (EquationSystems& es,
+                      const std::string& system_name, SparseMatrix<Number>& history)
+{
+#include "assemble_preamble.cpp"
+
+  history.zero();
+
+ for ( ; el != end_el; ++el)
+    {
+
+      const Elem* elem = *el;
+
+      dof_map.dof_indices (elem, dof_indices);
+      dof_map.dof_indices (elem, dof_indices_u, u_var);
+      dof_map.dof_indices (elem, dof_indices_v, v_var);
+      dof_map.dof_indices (elem, dof_indices_p, p_var);
+      dof_map.dof_indices (elem, dof_indices_x, x_var);
+      dof_map.dof_indices (elem, dof_indices_y, y_var);
+      #if THREED
+      dof_map.dof_indices (elem, dof_indices_w, w_var);
+      dof_map.dof_indices (elem, dof_indices_z, z_var);
+      #endif
+
+      const unsigned int n_dofs   = dof_indices.size();
+      const unsigned int n_u_dofs = dof_indices_u.size();
+      const unsigned int n_v_dofs = dof_indices_v.size();
+      const unsigned int n_p_dofs = dof_indices_p.size();
+      #if THREED
+      const unsigned int n_w_dofs = dof_indices_w.size();
+      #endif
+
+      fe_disp->reinit  (elem);
+      fe_vel->reinit  (elem);
+      fe_pres->reinit (elem);
+
+      Ke.resize (n_dofs, n_dofs);
+      Fe.resize (n_dofs);
+
+      Kpu.reposition (p_var*n_u_dofs, u_var*n_u_dofs, n_p_dofs, n_u_dofs);
+      Kpv.reposition (p_var*n_u_dofs, v_var*n_u_dofs, n_p_dofs, n_v_dofs);
+      #if THREED
+      Kpw.reposition (p_var*n_u_dofs, w_var*n_u_dofs, n_p_dofs, n_w_dofs);
+      #endif
+
+      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+        {
+          for (unsigned int i=0; i<n_p_dofs; i++)
+            for (unsigned int j=0; j<n_u_dofs; j++)
+            {
+              Kpu(i,j) += -JxW[qp]*psi[i][qp]*dphi[j][qp](0);
+              Kpv(i,j) += -JxW[qp]*psi[i][qp]*dphi[j][qp](1);
+              #if THREED
+              Kpw(i,j) += -JxW[qp]*psi[i][qp]*dphi[j][qp](2);
+              #endif
+            }
+        } // end qp
+
+      for (unsigned int i=0; i<n_dofs; i++)
+        if (boundary_dofs.constrained[dof_indices[i]])
+          for (unsigned int j=0; j<n_dofs; j++)
+            Ke(i,j) = 0.;
+
+  history.add_matrix (Ke, dof_indices);
+
+} // end of element loop
+
+    history.close();
+
+  return;
+}
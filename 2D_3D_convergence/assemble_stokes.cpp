@@ -151,6 +151,10 @@ Real lambda = (E*NU)/((1+NU)*(1-2*NU));
 
   DenseMatrix<Number> Kstab;
 
+  // Eliminated columns of the constrained dofs
+  DenseMatrix<Number> Le;
+  boundary_dofs.lift->zero();
+
 #if !THREED
   DenseSubMatrix<Number>
     Kuu(Ke), Kuv(Ke), Kup(Ke), Kux(Ke), Kuy(Ke),
@@ -450,20 +454,20 @@ std::vector<Real> stab_dofs_vals;
           //Mass conservation of mixture
           for (unsigned int i=0; i<n_p_dofs; i++){
             for (unsigned int j=0; j<n_u_dofs; j++){
-              Kpu(i,j) += JxW[qp]*psi[i][qp]*dphi[j][qp](0);
+              Kpu(i,j) += -JxW[qp]*psi[i][qp]*dphi[j][qp](0);
             }
           }
 
           for (unsigned int i=0; i<n_p_dofs; i++){
             for (unsigned int j=0; j<n_v_dofs; j++){
-              Kpv(i,j) += JxW[qp]*psi[i][qp]*dphi[j][qp](1);
+              Kpv(i,j) += -JxW[qp]*psi[i][qp]*dphi[j][qp](1);
             }
           }
 
           #if THREED
           for (unsigned int i=0; i<n_p_dofs; i++){
             for (unsigned int j=0; j<n_w_dofs; j++){
-              Kpw(i,j) += JxW[qp]*psi[i][qp]*dphi[j][qp](2);
+              Kpw(i,j) += -JxW[qp]*psi[i][qp]*dphi[j][qp](2);
             }
           }
           #endif
@@ -471,20 +475,20 @@ std::vector<Real> stab_dofs_vals;
 
           for (unsigned int i=0; i<n_p_dofs; i++){
             for (unsigned int j=0; j<n_x_dofs; j++){
-              Kpx(i,j) += dt*JxW[qp]*psi[i][qp]*f_dphi[j][qp](0);
+              Kpx(i,j) += -dt*JxW[qp]*psi[i][qp]*f_dphi[j][qp](0);
             }
           }
 
           for (unsigned int i=0; i<n_p_dofs; i++){
             for (unsigned int j=0; j<n_y_dofs; j++){
-              Kpy(i,j) += dt*JxW[qp]*psi[i][qp]*f_dphi[j][qp](1);
+              Kpy(i,j) += -dt*JxW[qp]*psi[i][qp]*f_dphi[j][qp](1);
             }
           }
 
           #if THREED
            for (unsigned int i=0; i<n_p_dofs; i++){
             for (unsigned int j=0; j<n_z_dofs; j++){
-              Kpz(i,j) += dt*JxW[qp]*psi[i][qp]*f_dphi[j][qp](2);
+              Kpz(i,j) += -dt*JxW[qp]*psi[i][qp]*f_dphi[j][qp](2);
             }
           }
           #endif
@@ -494,17 +498,17 @@ std::vector<Real> stab_dofs_vals;
 
           for (unsigned int i=0; i<n_p_dofs; i++){
             #if THREED
-            Fp(i) += (div_old_u(0)+div_old_u(1)+div_old_u(2))*JxW[qp]*psi[i][qp];
+            Fp(i) += -(div_old_u(0)+div_old_u(1)+div_old_u(2))*JxW[qp]*psi[i][qp];
             #endif
 
             #if !THREED
-            Fp(i) += (div_old_u(0)+div_old_u(1))*JxW[qp]*psi[i][qp];
+            Fp(i) += -(div_old_u(0)+div_old_u(1))*JxW[qp]*psi[i][qp];
             #endif
           }
 
         #if ANAL_2D
 					for (unsigned int i=0; i<n_p_dofs; i++){
-            Fp(i) += forcing_function_2D(q_point[qp], es.parameters)*JxW[qp]*psi[i][qp];
+            Fp(i) += -forcing_function_2D(q_point[qp], es.parameters)*JxW[qp]*psi[i][qp];
           }
         #endif
 
@@ -548,121 +552,28 @@ Real fluid_fac=f_dt*(1.0/KPERM);
   
 } // end qp
 
-	//Pressure jump stabilisation.
-#if USE_STAB  
- 	std::vector<unsigned int> stab_dofs_cols2;
-	std::vector<Real> stab_dofs_vals2;
-    for (unsigned int s=0; s<elem->n_sides(); s++)
-    {
-      if (elem->neighbor(s) == NULL)
-      {   
-				//Only do something on the interior edges.
-      } //if (elem->neighbor(s) == NULL)
-			else{
-
-      const Elem* neighbor = elem->neighbor(s);
-   		AutoPtr<Elem> side (elem->build_side(s));
-
-
-      std::vector<Real> node_co_ords_x;
-      std::vector<Real> node_co_ords_y;
-      for (unsigned int n=0; n<elem->n_nodes(); n++)
-      {
-          Node *e_node = elem->get_node(n);
-          for (unsigned int m=0; m<neighbor->n_nodes(); m++)
-          {
-            Node *n_node = neighbor->get_node(m);
-            if( ( (*n_node)(0)==(*e_node)(0) ) && ( (*n_node)(1)==(*e_node)(1) ) ){
-              node_co_ords_x.push_back((*n_node)(0));
-              node_co_ords_y.push_back((*n_node)(1));
-              }
-          }
-      }
-     Real side_length=pow ( pow((node_co_ords_x[0]-node_co_ords_x[1]),2) + pow((node_co_ords_y[0]-node_co_ords_y[1]),2),0.5) ;
-
-			std::vector<unsigned int> neighbor_dof_indices_p;
-      dof_map.dof_indices(neighbor, neighbor_dof_indices_p,p_var);
-      const unsigned int n_neighbor_dofs_p = neighbor_dof_indices_p.size();
-			Real hmax=(*elem).hmax();
-      Real hmin=(*elem).hmin();
-			//Real vol=(*elem).volume();
-  const Real DELTA    = es.parameters.get<Real>("DELTA");
-  Real delta=dt*DELTA;
-
-		//	Real delta=dt*PEN_STAB;
-      #if !THREED
-			Real factor=-delta*(hmax)*(hmax);;
-      //Real factor=-delta*(side_length);
-      #endif
-      
-      #if THREED
-      Real factor=-delta*(hmax*hmax*hmax);
-      #endif
-
-      //perf_log.push("push back");
-      stab_dofs_cols2.push_back(dof_indices_p[0]);
-      stab_dofs_vals2.push_back(-factor);
-      stab_dofs_cols2.push_back(neighbor_dof_indices_p[0]);
-      stab_dofs_vals2.push_back(factor);
-      //perf_log.pop("push back");
-			}
-		}
-
-	//Lots of mallocs happen during the first assemble due to the unexpected sparsity pattern;
-	//The implicit_neighbor_dof does not seem to work ?
-	//perf_log.push("kstab");
-  DenseMatrix<Number> Kstab2;
-  Kstab2.resize(1, stab_dofs_vals2.size());
- 	for (int i=0; i < stab_dofs_vals2.size(); i++) {
-	 	Kstab2(0,i)=stab_dofs_vals2[i];
-	}
- 	std::vector<unsigned int> stab_dofs_rows2;
-	stab_dofs_rows2.push_back(dof_indices_p[0]);
-	system.matrix->add_matrix(Kstab2,stab_dofs_rows2,stab_dofs_cols2);
-  test(4);
- 
-	//perf_log.pop("kstab");
-  #endif 
-  //endif USE_STAB
-
-#if USE_STAB 
-
-  #if THREED
-  #include "assemble_stokes_bcs_p1p1p0_anal_sine.cpp"
-  #include "pin_pressure.cpp"
-  #endif
-
-  #if !THREED
-  #include "assemble_stokes_bcs_p1p1p0_anal_sine.cpp"
-  #include "square_pin_pressure.cpp"
-  #endif
+	//Pressure jump stabilisation, after the element loop (pressure_jumps.cpp)
 
-
-#endif
+  //Dirichlet dofs, see boundary_dofs.cpp
+  constrain_element_matrix(Ke,Le,dof_indices,dof_indices);
+  constrain_element_vector(Fe,dof_indices);
 
   system.matrix->add_matrix (Ke, dof_indices);
+  boundary_dofs.lift->add_matrix (Le, dof_indices);
   system.rhs->add_vector    (Fe, dof_indices);
 
 } // end of element loop
+
+#if USE_STAB
+  assemble_pressure_jumps(es,system_name);
+#endif
   
     system.matrix->close();
+    boundary_dofs.lift->close();
     system.rhs->close();
-    system.matrix->zero_rows(rows, 1.0);
-
-    for (int i=0; i < rows.size(); i++) {
-      system.rhs->set(rows[i],rows_values[i]);
-    }
 
-		system.matrix->close();
-    system.rhs->close();
-
-    std::cout<<pressure_rows.size()<<std::endl;
-    system.matrix->zero_rows(pressure_rows, 1.0);
-    for (int i=0; i < pressure_rows.size(); i++) {
-      system.rhs->set(pressure_rows[i],pressure_rows_values[i]);
-    }
-    system.matrix->close();
-    system.rhs->close();
+    //Boundary values and their lift
+    add_dirichlet_lift(es,system_name);
 
     std::cout<<"Assemble rhs->l2_norm () "<<system.rhs->l2_norm ()<<std::endl;
 
@@ -0,0 +1,227 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "dof_map.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "petsc_matrix.h"
+#include "petsc_vector.h"
+#include "parallel.h"
+
+#include "assemble.h"
+
+// Block diagonal scaling of the saddle point system.
+//
+// The Darcy blocks carry dt/KPERM, Kpx/Kxp carry dt and the pressure
+// jump stabilisation carries DELTA*dt*h^2 while the elasticity blocks
+// are O(1).  Every variable gets a single factor s_v so that D*K*D has
+// O(1) rows in every block, with D=diag(s_v).  The factors are rounded
+// to powers of two so that scaling and unscaling the matrix is exact
+// and the stiffness matrix can be reused from one step to the next.
+//
+// Off by default, -block_scaling switches it on.
+
+
+// Largest/smallest row max-norm of the matrix, zero rows are ignored.
+Real row_norm_ratio (SparseMatrix<Number>& matrix, NumericVector<Number>& work)
+{
+  PetscMatrix<Number>* petsc_matrix = dynamic_cast<PetscMatrix<Number>*>(&matrix);
+  PetscVector<Number>* petsc_work = dynamic_cast<PetscVector<Number>*>(&work);
+  libmesh_assert (petsc_matrix != NULL);
+  libmesh_assert (petsc_work != NULL);
+
+  int ierr = MatGetRowMaxAbs(petsc_matrix->mat(), petsc_work->vec(), PETSC_NULL);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  work.close();
+
+  Real row_max = 0.;
+  Real row_min = 1.e300;
+  for (unsigned int i=work.first_local_index(); i<work.last_local_index(); i++)
+  {
+    const Real r = libmesh_real(work(i));
+    if (r > 0.)
+    {
+      row_max = std::max(row_max, r);
+      row_min = std::min(row_min, r);
+    }
+  }
+  Parallel::max(row_max);
+  Parallel::min(row_min);
+
+  return row_max/row_min;
+}
+
+
+void compute_block_scaling (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const DofMap & dof_map = system.get_dof_map();
+  const unsigned int n_vars = system.n_vars();
+  const unsigned int first_dof = dof_map.first_dof();
+  const unsigned int end_dof = dof_map.end_dof();
+
+  NumericVector<Number>& scaling = system.get_vector("block_scaling");
+  NumericVector<Number>& scaling_inv = system.get_vector("block_scaling_inverse");
+
+  system.matrix->close();
+
+  // Row max-norms of the unscaled matrix
+  const Real ratio_before = row_norm_ratio(*system.matrix, scaling);
+
+  // Variable number of every local dof
+  std::vector<unsigned int> dof_var(end_dof-first_dof, n_vars);
+  std::vector<unsigned int> dof_indices_var;
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+    for (unsigned int v=0; v<n_vars; v++)
+    {
+      dof_map.dof_indices (elem, dof_indices_var, v);
+      for (unsigned int i=0; i<dof_indices_var.size(); i++)
+        if ((dof_indices_var[i] >= first_dof) && (dof_indices_var[i] < end_dof))
+          dof_var[dof_indices_var[i]-first_dof] = v;
+    }
+  }
+
+  // Geometric mean of the row max-norms in each block
+  std::vector<Real> log_sum(n_vars, 0.);
+  std::vector<Real> n_rows(n_vars, 0.);
+  for (unsigned int i=first_dof; i<end_dof; i++)
+  {
+    const unsigned int v = dof_var[i-first_dof];
+    const Real r = libmesh_real(scaling(i));
+    if ((v < n_vars) && (r > 0.))
+    {
+      log_sum[v] += log(r);
+      n_rows[v] += 1.;
+    }
+  }
+  Parallel::sum(log_sum);
+  Parallel::sum(n_rows);
+
+  std::vector<Real> factor(n_vars, 1.);
+  for (unsigned int v=0; v<n_vars; v++)
+  {
+    if (n_rows[v] > 0.)
+    {
+      // s_v = 1/sqrt(mean row norm), rounded to a power of two
+      const Real log2_s = -0.5*(log_sum[v]/n_rows[v])/log(2.);
+      factor[v] = pow(2., floor(log2_s+0.5));
+    }
+    std::cout<<"Block scaling "<< system.variable_name(v) <<" "<< factor[v] <<std::endl;
+  }
+
+  for (unsigned int i=first_dof; i<end_dof; i++)
+  {
+    const unsigned int v = dof_var[i-first_dof];
+    const Real s = (v < n_vars) ? factor[v] : 1.;
+    scaling.set(i, s);
+    scaling_inv.set(i, 1./s);
+  }
+  scaling.close();
+  scaling_inv.close();
+
+  // Cheap condition estimate of the scaled matrix
+  PetscMatrix<Number>* petsc_matrix = dynamic_cast<PetscMatrix<Number>*>(system.matrix);
+  PetscVector<Number>* petsc_scaling = dynamic_cast<PetscVector<Number>*>(&scaling);
+  PetscVector<Number>* petsc_scaling_inv = dynamic_cast<PetscVector<Number>*>(&scaling_inv);
+
+  int ierr = MatDiagonalScale(petsc_matrix->mat(), petsc_scaling->vec(), petsc_scaling->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  AutoPtr<NumericVector<Number> > work = scaling.clone();
+  const Real ratio_after = row_norm_ratio(*system.matrix, *work);
+
+  ierr = MatDiagonalScale(petsc_matrix->mat(), petsc_scaling_inv->vec(), petsc_scaling_inv->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  std::cout<<"Block scaling row norm ratio "<< ratio_before <<" -> "<< ratio_after <<std::endl;
+
+  es.parameters.set<Real>("row_norm_ratio") = ratio_after;
+  es.parameters.set<bool>("block_scaling_ready") = true;
+}
+
+
+// Replace K x = f by (D K D) y = D f with x = D y.
+void apply_block_scaling (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  if (!es.parameters.have_parameter<bool>("block_scaling_ready") ||
+      !es.parameters.get<bool>("block_scaling_ready"))
+    compute_block_scaling(es, system_name);
+
+  PetscMatrix<Number>* petsc_matrix = dynamic_cast<PetscMatrix<Number>*>(system.matrix);
+  PetscVector<Number>* petsc_scaling = dynamic_cast<PetscVector<Number>*>(&system.get_vector("block_scaling"));
+  PetscVector<Number>* petsc_scaling_inv = dynamic_cast<PetscVector<Number>*>(&system.get_vector("block_scaling_inverse"));
+  PetscVector<Number>* petsc_rhs = dynamic_cast<PetscVector<Number>*>(system.rhs);
+  PetscVector<Number>* petsc_solution = dynamic_cast<PetscVector<Number>*>(system.solution.get());
+
+  system.matrix->close();
+  system.rhs->close();
+
+  int ierr = MatDiagonalScale(petsc_matrix->mat(), petsc_scaling->vec(), petsc_scaling->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecPointwiseMult(petsc_rhs->vec(), petsc_rhs->vec(), petsc_scaling->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  // Initial guess for the iterative solvers
+  ierr = VecPointwiseMult(petsc_solution->vec(), petsc_solution->vec(), petsc_scaling_inv->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  system.rhs->close();
+  system.solution->close();
+}
+
+
+// Undo apply_block_scaling: x = D y and K = D^-1 (D K D) D^-1.
+void remove_block_scaling (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  PetscMatrix<Number>* petsc_matrix = dynamic_cast<PetscMatrix<Number>*>(system.matrix);
+  PetscVector<Number>* petsc_scaling = dynamic_cast<PetscVector<Number>*>(&system.get_vector("block_scaling"));
+  PetscVector<Number>* petsc_scaling_inv = dynamic_cast<PetscVector<Number>*>(&system.get_vector("block_scaling_inverse"));
+  PetscVector<Number>* petsc_rhs = dynamic_cast<PetscVector<Number>*>(system.rhs);
+  PetscVector<Number>* petsc_solution = dynamic_cast<PetscVector<Number>*>(system.solution.get());
+
+  int ierr = MatDiagonalScale(petsc_matrix->mat(), petsc_scaling_inv->vec(), petsc_scaling_inv->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecPointwiseMult(petsc_rhs->vec(), petsc_rhs->vec(), petsc_scaling_inv->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecPointwiseMult(petsc_solution->vec(), petsc_solution->vec(), petsc_scaling->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  system.rhs->close();
+  system.solution->close();
+  system.update();
+}
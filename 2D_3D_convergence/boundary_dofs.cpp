@@ -0,0 +1,276 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "dof_map.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "elem.h"
+#include "dense_matrix.h"
+#include "dense_vector.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "parallel.h"
+
+#include "assemble.h"
+
+// Dirichlet rows of the analytic square/cube test, the same sets that
+// assemble_stokes_bcs_p1p1p0_anal_sine.cpp and (square_)pin_pressure.cpp
+// build on every assembly.  The geometric search runs once, every dof
+// appears once, and each step only evaluates the one exact function a
+// row needs.
+//
+// The constrained dofs are eliminated symmetrically during the element
+// assembly (constrain_element_matrix), so the stiffness matrix needs a
+// single close() and keeps its symmetry.  The eliminated columns are
+// kept in the "lift" matrix L, and the rhs of every step is F + L*g with
+// g the boundary values (add_dirichlet_lift).
+BoundaryDofs boundary_dofs;
+
+
+void build_boundary_dofs (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int u_var = system.variable_number ("s_u");
+  const unsigned int v_var = system.variable_number ("s_v");
+  #if THREED
+  const unsigned int w_var = system.variable_number ("s_w");
+  #endif
+  const unsigned int p_var = system.variable_number ("s_p");
+  const unsigned int x_var = system.variable_number ("x");
+  const unsigned int y_var = system.variable_number ("y");
+  #if THREED
+  const unsigned int z_var = system.variable_number ("z");
+  #endif
+
+  std::vector<unsigned int> dirichlet_vars;
+  dirichlet_vars.push_back(u_var);
+  dirichlet_vars.push_back(v_var);
+  #if THREED
+  dirichlet_vars.push_back(w_var);
+  #endif
+  dirichlet_vars.push_back(x_var);
+  dirichlet_vars.push_back(y_var);
+  #if THREED
+  dirichlet_vars.push_back(z_var);
+  #endif
+
+  boundary_dofs.rows.clear();
+  boundary_dofs.nodes.clear();
+  boundary_dofs.vars.clear();
+  boundary_dofs.pressure_rows.clear();
+  boundary_dofs.pressure_nodes.clear();
+
+  std::set<unsigned int> seen;
+  std::set<unsigned int> seen_pressure;
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+
+    for (unsigned int s=0; s<elem->n_sides(); s++)
+    {
+      if (elem->neighbor(s) != NULL)
+        continue;
+
+      AutoPtr<Elem> side (elem->build_side(s));
+
+      for (unsigned int ns=0; ns<side->n_nodes(); ns++)
+      {
+        const Node* node = side->get_node(ns);
+        const Real xf = (*node)(0);
+        const Real yf = (*node)(1);
+        #if THREED
+        const Real zf = (*node)(2);
+        #endif
+
+        #if !THREED
+        const bool on_boundary = (xf<0.001) || (xf>0.999) || (yf>0.999) || (yf<0.001);
+        const bool at_origin = (xf<0.001) && (yf<0.001);
+        #endif
+        #if THREED
+        const bool on_boundary = (xf<0.001) || (xf>0.999) || (yf>0.999) || (yf<0.001) || (zf>0.999) || (zf<0.001);
+        const bool at_origin = (xf<0.001) && (yf<0.001) && (zf<0.001);
+        #endif
+
+        if (on_boundary)
+        {
+          for (unsigned int v=0; v<dirichlet_vars.size(); v++)
+          {
+            const unsigned int source_dof = node->dof_number(system.number(), dirichlet_vars[v], 0);
+            if (source_dof == DofObject::invalid_id)
+              continue;
+            if (seen.insert(source_dof).second)
+            {
+              boundary_dofs.rows.push_back(source_dof);
+              boundary_dofs.nodes.push_back(node);
+              boundary_dofs.vars.push_back(dirichlet_vars[v]);
+            }
+          }
+        }
+
+        // Pin the (P0) pressure of the elements at the origin
+        if (at_origin)
+        {
+          const unsigned int source_dof = elem->dof_number(system.number(), p_var, 0);
+          if ((source_dof != DofObject::invalid_id) && seen_pressure.insert(source_dof).second)
+          {
+            boundary_dofs.pressure_rows.push_back(source_dof);
+            boundary_dofs.pressure_nodes.push_back(node);
+          }
+        }
+      }
+    }
+  }
+
+  boundary_dofs.values.resize(boundary_dofs.rows.size());
+  boundary_dofs.pressure_values.resize(boundary_dofs.pressure_rows.size());
+
+  // A boundary dof can belong to an element of this process that has no
+  // side on the boundary, so the flags need the sets of all processes
+  std::vector<int> all_rows(boundary_dofs.rows);
+  all_rows.insert(all_rows.end(), boundary_dofs.pressure_rows.begin(), boundary_dofs.pressure_rows.end());
+  Parallel::allgather(all_rows);
+
+  boundary_dofs.constrained.assign(system.n_dofs(), false);
+  for (unsigned int i=0; i<all_rows.size(); i++)
+    boundary_dofs.constrained[all_rows[i]] = true;
+
+  std::cout<<"Boundary dofs "<< boundary_dofs.rows.size() <<", pinned pressure dofs "<< boundary_dofs.pressure_rows.size() <<std::endl;
+}
+
+
+// Exact values of the boundary rows at the current "time".
+void update_boundary_values (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int u_var = system.variable_number ("s_u");
+  const unsigned int v_var = system.variable_number ("s_v");
+  #if THREED
+  const unsigned int w_var = system.variable_number ("s_w");
+  #endif
+  const unsigned int x_var = system.variable_number ("x");
+  const unsigned int y_var = system.variable_number ("y");
+  #if THREED
+  const unsigned int z_var = system.variable_number ("z");
+  #endif
+
+  for (unsigned int i=0; i<boundary_dofs.rows.size(); i++)
+  {
+    const Point& p = *boundary_dofs.nodes[i];
+    const unsigned int var = boundary_dofs.vars[i];
+
+    Number value = 0;
+    if (var == u_var)
+      value = exact_2D_solution_u(p, es.parameters,"null","void");
+    else if (var == v_var)
+      value = exact_2D_solution_v(p, es.parameters,"null","void");
+    #if THREED
+    else if (var == w_var)
+      value = exact_2D_solution_w(p, es.parameters,"null","void");
+    #endif
+    else if (var == x_var)
+      value = exact_2D_solution_x(p, es.parameters,"null","void");
+    else if (var == y_var)
+      value = exact_2D_solution_y(p, es.parameters,"null","void");
+    #if THREED
+    else if (var == z_var)
+      value = exact_2D_solution_z(p, es.parameters,"null","void");
+    #endif
+
+    boundary_dofs.values[i] = value;
+  }
+
+  for (unsigned int i=0; i<boundary_dofs.pressure_rows.size(); i++)
+    boundary_dofs.pressure_values[i] = exact_2D_solution_p(*boundary_dofs.pressure_nodes[i], es.parameters,"null","void");
+}
+
+
+// Symmetric elimination of the constrained dofs from an element matrix.
+// The rows and columns of the constrained dofs are removed from Ke, which
+// keeps a one on their diagonal.  The removed columns go to Le with the
+// opposite sign, and Le has the same diagonal as Ke, so a constrained row
+// reads n*x_i = n*g_i with n the number of contributions to it.
+void constrain_element_matrix (DenseMatrix<Number>& Ke, DenseMatrix<Number>& Le,
+                      const std::vector<unsigned int>& row_dofs, const std::vector<unsigned int>& col_dofs)
+{
+  Le.resize (Ke.m(), Ke.n());
+
+  for (unsigned int i=0; i<row_dofs.size(); i++)
+  {
+    const bool row_constrained = boundary_dofs.constrained[row_dofs[i]];
+
+    for (unsigned int j=0; j<col_dofs.size(); j++)
+    {
+      if (row_constrained)
+      {
+        const Number diagonal = (row_dofs[i] == col_dofs[j]) ? 1. : 0.;
+        Ke(i,j) = diagonal;
+        Le(i,j) = diagonal;
+      }
+      else if (boundary_dofs.constrained[col_dofs[j]])
+      {
+        Le(i,j) = -Ke(i,j);
+        Ke(i,j) = 0.;
+      }
+    }
+  }
+}
+
+
+// The constrained rows of the rhs only get the lift.
+void constrain_element_vector (DenseVector<Number>& Fe,
+                      const std::vector<unsigned int>& dof_indices)
+{
+  for (unsigned int i=0; i<dof_indices.size(); i++)
+    if (boundary_dofs.constrained[dof_indices[i]])
+      Fe(i) = 0.;
+}
+
+
+// Adds L*g to the (closed) rhs, with g the boundary values at the current
+// "time".
+void add_dirichlet_lift (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+  libmesh_assert (boundary_dofs.lift != NULL);
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  update_boundary_values(es,system_name);
+
+  NumericVector<Number>& g = system.get_vector("dirichlet_values");
+  g.zero();
+  for (unsigned int i=0; i<boundary_dofs.rows.size(); i++)
+    g.set(boundary_dofs.rows[i],boundary_dofs.values[i]);
+  for (unsigned int i=0; i<boundary_dofs.pressure_rows.size(); i++)
+    g.set(boundary_dofs.pressure_rows[i],boundary_dofs.pressure_values[i]);
+  g.close();
+
+  system.rhs->add_vector(g, *boundary_dofs.lift);
+}
@@ -0,0 +1,339 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "fe.h"
+#include "quadrature_gauss.h"
+#include "dof_map.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "dense_matrix.h"
+#include "dense_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "elem.h"
+
+#include "assemble.h"
+
+// Error norms in an auxiliary MONOMIAL space of order ERROR_ORDER
+// (-error_norms projection).
+//
+// The spatial part X(x) of the exact solution is L2 projected on every
+// element once ("error_reference").  The FE solution lies in the
+// auxiliary space, its coefficients there are P_e*x_e with the element
+// operators P_e = M_e^-1 B_e, also computed once.  Every step forms
+//
+//   e = T(time)*reference - P*x
+//
+// and the norms are e^T K e with the mass, broken H1 and div matrices
+// of the auxiliary space, assembled once.  The exact quadrature in
+// assemble_error stays the default and can be used to validate this.
+
+struct ErrorProjectionElement
+{
+  // Dofs of the auxiliary and of the FE variables, in the order
+  // u,v(,w), x,y(,z), p
+  std::vector<std::vector<unsigned int> > aux_dofs;
+  std::vector<std::vector<unsigned int> > dofs;
+
+  // P_e of the displacement, velocity and pressure variables
+  DenseMatrix<Number> P_disp, P_vel, P_p;
+};
+
+std::vector<ErrorProjectionElement> error_projection_elements;
+
+// The norm matrices of the auxiliary system, L2 u, H1 semi u, L2 z,
+// Hdiv semi z and L2 p
+const char* error_norm_matrices[] = {"error_mass_disp", "error_stiffness_disp",
+  "error_mass_vel", "error_div_vel", "error_mass_press"};
+const unsigned int n_error_norm_matrices = 5;
+
+
+// Before init
+void add_error_projection (EquationSystems& es)
+{
+  LinearImplicitSystem & projection =
+    es.add_system<LinearImplicitSystem> ("error_projection");
+
+  projection.add_variable ("e_u", ERROR_ORDER, MONOMIAL);
+  projection.add_variable ("e_v", ERROR_ORDER, MONOMIAL);
+  #if THREED
+  projection.add_variable ("e_w", ERROR_ORDER, MONOMIAL);
+  #endif
+  projection.add_variable ("e_x", ERROR_ORDER, MONOMIAL);
+  projection.add_variable ("e_y", ERROR_ORDER, MONOMIAL);
+  #if THREED
+  projection.add_variable ("e_z", ERROR_ORDER, MONOMIAL);
+  #endif
+  projection.add_variable ("e_p", ERROR_ORDER, MONOMIAL);
+
+  for (unsigned int k=0; k<n_error_norm_matrices; k++)
+    projection.add_matrix (error_norm_matrices[k]);
+
+  projection.add_vector ("error_reference", false);
+  projection.add_vector ("error_difference", false);
+  projection.add_vector ("error_product", false);
+}
+
+
+// M_e^-1 B
+void error_mass_solve (const DenseMatrix<Number>& M, const DenseMatrix<Number>& B, DenseMatrix<Number>& X)
+{
+  X.resize(B.m(), B.n());
+
+  DenseVector<Number> b(B.m()), x;
+  for (unsigned int j=0; j<B.n(); j++)
+  {
+    for (unsigned int i=0; i<B.m(); i++)
+      b(i) = B(i,j);
+
+    DenseMatrix<Number> M_lu = M;
+    M_lu.lu_solve(b, x);
+
+    for (unsigned int i=0; i<B.m(); i++)
+      X(i,j) = x(i);
+  }
+}
+
+
+void build_error_projection (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+  const unsigned int dim = mesh.mesh_dimension();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+  LinearImplicitSystem & projection =
+    es.get_system<LinearImplicitSystem> ("error_projection");
+
+  #if !THREED
+  const char* names[] = {"s_u", "s_v", "x", "y", "s_p"};
+  const ExactValue exact[] = {exact_2D_solution_u, exact_2D_solution_v,
+    exact_2D_solution_x, exact_2D_solution_y, exact_2D_solution_p};
+  #endif
+  #if THREED
+  const char* names[] = {"s_u", "s_v", "s_w", "x", "y", "z", "s_p"};
+  const ExactValue exact[] = {exact_2D_solution_u, exact_2D_solution_v, exact_2D_solution_w,
+    exact_2D_solution_x, exact_2D_solution_y, exact_2D_solution_z, exact_2D_solution_p};
+  #endif
+  const unsigned int n_vars = sizeof(names)/sizeof(names[0]);
+  const unsigned int n_components = (n_vars-1)/2;
+
+  AutoPtr<FEBase> fe_aux  (FEBase::build(dim, projection.variable_type(0)));
+  AutoPtr<FEBase> fe_disp (FEBase::build(dim, system.variable_type(system.variable_number("s_u"))));
+  AutoPtr<FEBase> fe_vel  (FEBase::build(dim, system.variable_type(system.variable_number("x"))));
+  AutoPtr<FEBase> fe_pres (FEBase::build(dim, system.variable_type(system.variable_number("s_p"))));
+
+  QGauss qrule (dim, EIGHTH);
+  fe_aux->attach_quadrature_rule (&qrule);
+  fe_disp->attach_quadrature_rule (&qrule);
+  fe_vel->attach_quadrature_rule (&qrule);
+  fe_pres->attach_quadrature_rule (&qrule);
+
+  const std::vector<Real>& JxW = fe_aux->get_JxW();
+  const std::vector<Point>& q_point = fe_aux->get_xyz();
+  const std::vector<std::vector<Real> >& phi_aux = fe_aux->get_phi();
+  const std::vector<std::vector<RealGradient> >& dphi_aux = fe_aux->get_dphi();
+  const std::vector<std::vector<Real> >& phi = fe_disp->get_phi();
+  const std::vector<std::vector<Real> >& f_phi = fe_vel->get_phi();
+  const std::vector<std::vector<Real> >& psi = fe_pres->get_phi();
+
+  const DofMap & dof_map = system.get_dof_map();
+  const DofMap & aux_dof_map = projection.get_dof_map();
+
+  NumericVector<Number>& reference = projection.get_vector("error_reference");
+  std::vector<SparseMatrix<Number>*> norm_matrices(n_error_norm_matrices);
+  for (unsigned int k=0; k<n_error_norm_matrices; k++)
+  {
+    norm_matrices[k] = &projection.get_matrix(error_norm_matrices[k]);
+    norm_matrices[k]->zero();
+  }
+
+  // The exact functions give X(x) at the reference time
+  const Real time = es.parameters.get<Real>("time");
+  es.parameters.set<Real>("time") = exact_2D_reference_time();
+
+  DenseMatrix<Number> Me, Ke, B;
+  std::vector<DenseMatrix<Number> > De(n_components*n_components);
+  DenseVector<Number> be, re;
+
+  error_projection_elements.clear();
+  error_projection_elements.reserve(mesh.n_active_local_elem());
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+
+    error_projection_elements.push_back(ErrorProjectionElement());
+    ErrorProjectionElement& cache = error_projection_elements.back();
+
+    fe_aux->reinit  (elem);
+    fe_disp->reinit (elem);
+    fe_vel->reinit  (elem);
+    fe_pres->reinit (elem);
+
+    cache.aux_dofs.resize(n_vars);
+    cache.dofs.resize(n_vars);
+    for (unsigned int v=0; v<n_vars; v++)
+    {
+      aux_dof_map.dof_indices (elem, cache.aux_dofs[v], v);
+      dof_map.dof_indices (elem, cache.dofs[v], system.variable_number(names[v]));
+    }
+
+    const unsigned int n_aux = cache.aux_dofs[0].size();
+    Me.resize(n_aux, n_aux);
+    Ke.resize(n_aux, n_aux);
+    for (unsigned int k=0; k<De.size(); k++)
+      De[k].resize(n_aux, n_aux);
+
+    for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+      for (unsigned int i=0; i<n_aux; i++)
+        for (unsigned int j=0; j<n_aux; j++)
+        {
+          Me(i,j) += JxW[qp]*phi_aux[i][qp]*phi_aux[j][qp];
+          Ke(i,j) += JxW[qp]*dphi_aux[i][qp]*dphi_aux[j][qp];
+          for (unsigned int c=0; c<n_components; c++)
+            for (unsigned int d=0; d<n_components; d++)
+              De[c*n_components+d](i,j) += JxW[qp]*dphi_aux[i][qp](c)*dphi_aux[j][qp](d);
+        }
+
+    // Mass, stiffness and div blocks of the norms
+    for (unsigned int c=0; c<n_components; c++)
+    {
+      const std::vector<unsigned int>& disp_dofs = cache.aux_dofs[c];
+      const std::vector<unsigned int>& vel_dofs = cache.aux_dofs[n_components+c];
+      norm_matrices[0]->add_matrix(Me, disp_dofs, disp_dofs);
+      norm_matrices[1]->add_matrix(Ke, disp_dofs, disp_dofs);
+      norm_matrices[2]->add_matrix(Me, vel_dofs, vel_dofs);
+      for (unsigned int d=0; d<n_components; d++)
+        norm_matrices[3]->add_matrix(De[c*n_components+d], vel_dofs, cache.aux_dofs[n_components+d]);
+    }
+    norm_matrices[4]->add_matrix(Me, cache.aux_dofs[n_vars-1], cache.aux_dofs[n_vars-1]);
+
+    // Projection of X
+    for (unsigned int v=0; v<n_vars; v++)
+    {
+      be.resize(n_aux);
+      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+      {
+        const Number X = exact[v](q_point[qp], es.parameters,"null","void");
+        for (unsigned int i=0; i<n_aux; i++)
+          be(i) += JxW[qp]*X*phi_aux[i][qp];
+      }
+
+      DenseMatrix<Number> M_lu = Me;
+      M_lu.lu_solve(be, re);
+      for (unsigned int i=0; i<n_aux; i++)
+        reference.set(cache.aux_dofs[v][i], re(i));
+    }
+
+    // P_e of every variable group
+    const std::vector<std::vector<Real> >* group_phi[] = {&phi, &f_phi, &psi};
+    DenseMatrix<Number>* group_P[] = {&cache.P_disp, &cache.P_vel, &cache.P_p};
+    const unsigned int group_var[] = {0, n_components, n_vars-1};
+    for (unsigned int g=0; g<3; g++)
+    {
+      const std::vector<std::vector<Real> >& phi_g = *group_phi[g];
+      const unsigned int n_g = cache.dofs[group_var[g]].size();
+
+      B.resize(n_aux, n_g);
+      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+        for (unsigned int i=0; i<n_aux; i++)
+          for (unsigned int j=0; j<n_g; j++)
+            B(i,j) += JxW[qp]*phi_aux[i][qp]*phi_g[j][qp];
+
+      error_mass_solve(Me, B, *group_P[g]);
+    }
+  }
+
+  reference.close();
+  for (unsigned int k=0; k<n_error_norm_matrices; k++)
+    norm_matrices[k]->close();
+
+  es.parameters.set<Real>("time") = time;
+}
+
+
+void projected_error (Real& H1_semi_error_disp, Real& Hdiv_semi_error_vel, Real& L2_error_press, Real& L2_error_displacement, Real& L2_error_velocity, EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+  LinearImplicitSystem & projection =
+    es.get_system<LinearImplicitSystem> ("error_projection");
+
+  if (error_projection_elements.empty())
+    build_error_projection(es,system_name);
+
+  const Real time_factor = exact_2D_time_factor(es.parameters.get<Real>("time"));
+
+  NumericVector<Number>& reference = projection.get_vector("error_reference");
+  NumericVector<Number>& difference = projection.get_vector("error_difference");
+  NumericVector<Number>& product = projection.get_vector("error_product");
+
+  // P*x, element by element
+  DenseVector<Number> x_e;
+  for (unsigned int e=0; e<error_projection_elements.size(); e++)
+  {
+    const ErrorProjectionElement& cache = error_projection_elements[e];
+    const unsigned int n_vars = cache.dofs.size();
+    const unsigned int n_components = (n_vars-1)/2;
+
+    for (unsigned int v=0; v<n_vars; v++)
+    {
+      const DenseMatrix<Number>& P = (v < n_components) ? cache.P_disp :
+        ( (v < n_vars-1) ? cache.P_vel : cache.P_p );
+
+      x_e.resize(cache.dofs[v].size());
+      for (unsigned int j=0; j<cache.dofs[v].size(); j++)
+        x_e(j) = system.current_solution(cache.dofs[v][j]);
+
+      for (unsigned int i=0; i<cache.aux_dofs[v].size(); i++)
+      {
+        Number Px = 0.;
+        for (unsigned int j=0; j<x_e.size(); j++)
+          Px += P(i,j)*x_e(j);
+        difference.set(cache.aux_dofs[v][i], -Px);
+      }
+    }
+  }
+  difference.close();
+  difference.add(time_factor, reference);
+
+  std::vector<Real> errors(n_error_norm_matrices);
+  for (unsigned int k=0; k<n_error_norm_matrices; k++)
+  {
+    product.zero();
+    product.add_vector(difference, projection.get_matrix(error_norm_matrices[k]));
+    errors[k] = std::max(difference.dot(product), 0.);
+  }
+
+  L2_error_displacement=sqrt(errors[0]);
+  H1_semi_error_disp=sqrt(errors[1]);
+  L2_error_velocity=sqrt(errors[2]);
+  Hdiv_semi_error_vel=sqrt(errors[3]);
+  L2_error_press=sqrt(errors[4]);
+}
+
+
+// The caches of both error norms are built again on first use
+void clear_error_caches ()
+{
+  error_elements.clear();
+  error_projection_elements.clear();
+}
@@ -669,3 +669,23 @@ t=FIX_T;
   #endif
 
   }
+
+// Every exact solution is X(x)*T(t), T is returned here.  At
+// exact_2D_reference_time() T is one and the functions above give X.
+Real exact_2D_time_factor(const Real t)
+{
+#if SIN && TIME && !TTEST
+  return sin(2*PIE*t);
+#else
+  return 1.;
+#endif
+}
+
+Real exact_2D_reference_time()
+{
+#if SIN && TIME && !TTEST
+  return 0.25;
+#else
+  return 0.;
+#endif
+}
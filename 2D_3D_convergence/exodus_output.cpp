@@ -0,0 +1,172 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "exodusII_io_helper.h"
+
+#include "assemble.h"
+
+#ifdef LIBMESH_HAVE_EXODUS_API
+
+// All steps of a run in one Exodus file, result_file_name + ".e".
+//
+// The mesh is written once when the file is created, every written step
+// appends a time and the values of the selected variables only,
+//
+//   -output_variables "s_u s_v s_p"   variables to write (default all)
+//   -output_stride 4                  write every 4th step (default 1)
+//
+// Element (CONSTANT MONOMIAL) variables such as the P0 pressure are
+// written as Exodus element variables, the per element values of
+// get_solution.
+
+struct ExodusOutput
+{
+  ExodusII_IO_Helper* helper;
+  std::string file_name;
+
+  // Selected variables and their columns in build_solution_vector
+  std::vector<std::string> names;
+  std::vector<unsigned int> columns;
+
+  // Selected element variables and their index in get_solution
+  std::vector<std::string> element_names;
+  std::vector<unsigned int> element_index;
+
+  unsigned int stride;
+  int n_written;
+};
+
+ExodusOutput exodus_output;
+
+
+void open_output (EquationSystems& es, const std::string& file_name)
+{
+  exodus_output.helper = NULL;
+  exodus_output.file_name = file_name;
+  exodus_output.stride = std::max(command_line_value("-output_stride", 1), 1);
+  exodus_output.n_written = 0;
+
+  std::vector<std::string> all_names;
+  es.build_variable_names(all_names);
+
+  std::vector<std::string> selected;
+  std::istringstream list(command_line_value("-output_variables", std::string()));
+  std::string name;
+  while (list >> name)
+    selected.push_back(name);
+
+  // The element variables are those get_solution returns (collective)
+  std::vector<Number> element_soln;
+  std::vector<std::string> element_names;
+  es.get_solution(element_soln, element_names);
+
+  exodus_output.names.clear();
+  exodus_output.columns.clear();
+  exodus_output.element_names.clear();
+  exodus_output.element_index.clear();
+  for (unsigned int c=0; c<all_names.size(); c++)
+    if (selected.empty() || (std::find(selected.begin(), selected.end(), all_names[c]) != selected.end()))
+    {
+      const std::vector<std::string>::const_iterator it =
+        std::find(element_names.begin(), element_names.end(), all_names[c]);
+      if (it == element_names.end())
+      {
+        exodus_output.names.push_back(all_names[c]);
+        exodus_output.columns.push_back(c);
+      }
+      else
+      {
+        exodus_output.element_names.push_back(all_names[c]);
+        exodus_output.element_index.push_back(it - element_names.begin());
+      }
+    }
+
+  for (unsigned int k=0; k<selected.size(); k++)
+    if (std::find(all_names.begin(), all_names.end(), selected[k]) == all_names.end())
+      std::cerr<<"Unknown output variable "<< selected[k] <<std::endl;
+}
+
+
+// Appends step "step" at "time" if it falls on the output stride
+void write_output (EquationSystems& es, const unsigned int step, const Real time)
+{
+  if (step % exodus_output.stride != 0)
+    return;
+
+  // Collective, only processor 0 writes
+  std::vector<Number> soln;
+  es.build_solution_vector(soln);
+
+  std::vector<Number> element_soln;
+  if (!exodus_output.element_names.empty())
+  {
+    std::vector<std::string> element_names;
+    es.get_solution(element_soln, element_names);
+  }
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  const MeshBase& mesh = es.get_mesh();
+
+  if (exodus_output.helper == NULL)
+  {
+    exodus_output.helper = new ExodusII_IO_Helper;
+    exodus_output.helper->create(exodus_output.file_name);
+    exodus_output.helper->initialize(exodus_output.file_name, mesh);
+    exodus_output.helper->write_nodal_coordinates(mesh);
+    exodus_output.helper->write_elements(mesh);
+    exodus_output.helper->initialize_nodal_variables(exodus_output.names);
+    if (!exodus_output.element_names.empty())
+      exodus_output.helper->initialize_element_variables(mesh, exodus_output.element_names);
+  }
+
+  exodus_output.n_written++;
+  exodus_output.helper->write_timestep(exodus_output.n_written, time);
+
+  const unsigned int n_nodes = mesh.n_nodes();
+  const unsigned int n_vars = soln.size()/n_nodes;
+  std::vector<Number> values(n_nodes);
+  for (unsigned int k=0; k<exodus_output.columns.size(); k++)
+  {
+    for (unsigned int i=0; i<n_nodes; i++)
+      values[i] = soln[i*n_vars + exodus_output.columns[k]];
+    exodus_output.helper->write_nodal_values(k+1, values, exodus_output.n_written);
+  }
+
+  // get_solution and write_element_values both order by variable, then element id
+  const unsigned int n_elem = mesh.n_elem();
+  const unsigned int n_element = exodus_output.element_index.size();
+  if (n_element > 0)
+  {
+    std::vector<Number> element_values(n_element*n_elem);
+    for (unsigned int k=0; k<n_element; k++)
+      std::copy(element_soln.begin() + exodus_output.element_index[k]*n_elem,
+                element_soln.begin() + (exodus_output.element_index[k]+1)*n_elem,
+                element_values.begin() + k*n_elem);
+    exodus_output.helper->write_element_values(mesh, element_values, exodus_output.n_written);
+  }
+
+  std::cout<<"exodus "<< exodus_output.file_name <<" step "<< exodus_output.n_written <<std::endl;
+}
+
+
+void close_output ()
+{
+  if (exodus_output.helper == NULL)
+    return;
+
+  exodus_output.helper->close();
+  delete exodus_output.helper;
+  exodus_output.helper = NULL;
+}
+
+#endif // LIBMESH_HAVE_EXODUS_API
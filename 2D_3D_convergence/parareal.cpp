@@ -0,0 +1,396 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <cstdlib>
+#include <sys/time.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "linear_solver.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include <petsc_linear_solver.h>
+#include "petsc_vector.h"
+
+#include "assemble.h"
+
+// Parareal over the time interval [0,end_time] split into N slices of
+// m = n_timesteps/N fine steps each,
+//   U_{n+1}^{k+1} = G(U_n^{k+1}) + F(U_n^k) - G(U_n^k),
+// with the fine propagator F = m backward Euler steps of advance_time_step
+// and the coarse propagator G = one backward Euler step over the slice.
+// G has its own matrices ("coarse_stiffness", "coarse_dirichlet_lift")
+// and linear solver, so the LU factorisations of both propagators are
+// kept for the whole run.
+//
+// The fine propagations run concurrently on processor groups,
+//
+//   mpirun -np 8 ex11-opt ... -parareal_slices 4 -parareal_groups 4
+//
+// splits MPI_COMM_WORLD into 4 groups of 2 processors before libMesh is
+// initialised, so every group has its own copy of the mesh and systems on
+// its own communicator.  Group g propagates the slices n = g mod G, the
+// ends of the slices are then broadcast between the groups and every
+// group does the (cheap, sequential) coarse correction itself.  The
+// groups partition the mesh alike, so the same processor of every group
+// holds the same dofs.  Only group 0 writes output.  Without
+// -parareal_groups the slices are propagated one after another.
+//
+// Only the 2D_3D_convergence driver has a Parareal path.
+
+
+// Processor groups of -parareal_groups, "slices" connects the same
+// processor of every group
+struct PararealComm
+{
+  unsigned int n_groups;
+  unsigned int group;
+  MPI_Comm group_comm;
+  MPI_Comm slices;
+  bool initialized_mpi;
+
+  PararealComm () : n_groups(1), group(0), initialized_mpi(false) {}
+
+  // After LibMeshInit is destroyed
+  ~PararealComm ()
+  {
+    if (n_groups > 1)
+    {
+      MPI_Comm_free(&group_comm);
+      MPI_Comm_free(&slices);
+    }
+    if (initialized_mpi)
+      MPI_Finalize();
+  }
+};
+
+PararealComm parareal_comm;
+
+
+// The communicator libMesh is initialised with, MPI_COMM_WORLD or the
+// group of this processor for -parareal_groups
+MPI_Comm parareal_split_world (int& argc, char**& argv)
+{
+  int n_groups = 1;
+  for (int i=1; i+1<argc; i++)
+    if (std::string(argv[i]) == "-parareal_groups")
+      n_groups = atoi(argv[i+1]);
+  if (n_groups <= 1)
+    return MPI_COMM_WORLD;
+
+  int flag;
+  MPI_Initialized(&flag);
+  if (!flag)
+  {
+    MPI_Init(&argc, &argv);
+    parareal_comm.initialized_mpi = true;
+  }
+
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  if (size % n_groups != 0)
+  {
+    std::cerr<<"parareal_groups must divide the number of processors"<<std::endl;
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  const int group_size = size/n_groups;
+  parareal_comm.n_groups = n_groups;
+  parareal_comm.group = rank/group_size;
+  MPI_Comm_split(MPI_COMM_WORLD, parareal_comm.group, rank, &parareal_comm.group_comm);
+  MPI_Comm_split(MPI_COMM_WORLD, rank % group_size, parareal_comm.group, &parareal_comm.slices);
+
+  return parareal_comm.group_comm;
+}
+
+
+// Group of this processor, 0 without -parareal_groups
+unsigned int parareal_group ()
+{
+  return parareal_comm.group;
+}
+
+
+Real parareal_wall_time ()
+{
+  timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec + 1.e-6*now.tv_usec;
+}
+
+
+// Copies the local part of v on group "root" to the same processor of
+// every group
+void parareal_broadcast (NumericVector<Number>& v, const unsigned int root)
+{
+  PetscVector<Number>* petsc_v = dynamic_cast<PetscVector<Number>*>(&v);
+  libmesh_assert (petsc_v != NULL);
+
+  PetscScalar* array;
+  int ierr = VecGetArray(petsc_v->vec(), &array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MPI_Bcast(array, v.local_size(), MPIU_SCALAR, root, parareal_comm.slices);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecRestoreArray(petsc_v->vec(), &array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  v.close();
+}
+
+
+// One coarse backward Euler step from old_local_solution with step "dt".
+void coarse_time_step (EquationSystems& es, const std::string& system_name,
+                      LinearSolver<Number>& coarse_solver)
+{
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> (system_name);
+
+  // Assemble into the coarse matrices
+  SparseMatrix<Number>* fine_matrix = system.matrix;
+  SparseMatrix<Number>* fine_lift = boundary_dofs.lift;
+  system.matrix = &system.get_matrix("coarse_stiffness");
+  boundary_dofs.lift = &system.get_matrix("coarse_dirichlet_lift");
+
+  const bool new_matrix = !es.parameters.have_parameter<Real>("coarse_assembled_dt") ||
+    (es.parameters.get<Real>("coarse_assembled_dt") != es.parameters.get<Real>("dt"));
+  if (new_matrix)
+  {
+    update_stiffness(es,system_name);
+    es.parameters.set<Real>("coarse_assembled_dt") = es.parameters.get<Real>("dt");
+  }
+  coarse_solver.same_preconditioner = !new_matrix;
+
+  system.rhs->zero();
+  assemble_rhs(es,system_name);
+
+  coarse_solver.solve (*system.matrix, *system.solution, *system.rhs,
+                       es.parameters.get<Real>("linear solver tolerance"),
+                       es.parameters.get<unsigned int>("linear solver maximum iterations"));
+
+  system.matrix = fine_matrix;
+  boundary_dofs.lift = fine_lift;
+  system.update();
+}
+
+
+// n_steps steps of size dt from "start" at time t0, the end state is left
+// in the system.  The solution after every step is appended to "steps"
+// when it is given.
+void propagate (EquationSystems& es, const std::string& system_name,
+                      const NumericVector<Number>& start, const Real t0, const Real dt,
+                      const unsigned int n_steps, LinearSolver<Number>* coarse_solver,
+                      std::vector<NumericVector<Number>*>* steps)
+{
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> (system_name);
+
+  *system.solution = start;
+  system.update();
+
+  for (unsigned int j=0; j<n_steps; j++)
+  {
+    *system.old_local_solution = *system.current_local_solution;
+
+    es.parameters.set<Real> ("time") = t0 + (j+1)*dt;
+    es.parameters.set<Real> ("dt") = dt;
+    es.parameters.set<Real> ("dt_old") = dt;
+    // The state is a single solution vector, so every step is backward Euler
+    es.parameters.set<unsigned int>("step") = 1;
+
+    if (coarse_solver)
+      coarse_time_step(es, system_name, *coarse_solver);
+    else
+      advance_time_step(es, system_name);
+
+    if (steps)
+      steps->push_back(system.solution->clone().release());
+  }
+}
+
+
+// Fills "solutions" with the solution after every fine step (owned by
+// the caller).
+void parareal_solve (EquationSystems& es, const std::string& system_name,
+                      std::vector<NumericVector<Number>*>& solutions)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int n_timesteps = es.parameters.get<Real>("n_timesteps");
+  const unsigned int n_slices = es.parameters.get<unsigned int>("parareal_slices");
+  const Real tol = es.parameters.get<Real>("parareal_tol");
+  const Real end_time = es.parameters.get<Real>("end_time");
+  const unsigned int n_groups = parareal_comm.n_groups;
+  const unsigned int group = parareal_comm.group;
+
+  libmesh_assert (n_timesteps % n_slices == 0);
+  const unsigned int m = n_timesteps/n_slices;
+  const Real dt_coarse = end_time/n_slices;
+  const Real dt_fine = dt_coarse/m;
+
+  if (n_slices % n_groups != 0)
+  {
+    std::cerr<<"parareal_groups must divide parareal_slices"<<std::endl;
+    libmesh_error();
+  }
+
+  // The broadcasts need the same local dofs on every group
+  if (n_groups > 1)
+  {
+    unsigned int range[2] = {system.solution->first_local_index(), system.solution->last_local_index()};
+    unsigned int root_range[2] = {range[0], range[1]};
+    MPI_Bcast(root_range, 2, MPI_UNSIGNED, 0, parareal_comm.slices);
+    if ( (range[0] != root_range[0]) || (range[1] != root_range[1]) )
+    {
+      std::cerr<<"The Parareal groups partition the mesh differently"<<std::endl;
+      libmesh_error();
+    }
+  }
+
+  std::cout<<"Parareal with "<< n_slices <<" slices of "<< m <<" fine steps on "<< n_groups <<" groups"<<std::endl;
+
+  AutoPtr<LinearSolver<Number> > coarse_solver = LinearSolver<Number>::build();
+#if PETSC_MUMPS
+  PetscLinearSolver<Number>* petsc_coarse_solver = dynamic_cast<PetscLinearSolver<Number>*>(coarse_solver.get());
+  petsc_coarse_solver->init();
+  int ierr = PCSetType(petsc_coarse_solver->pc(), PC_TYPE);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = PCFactorSetMatSolverPackage(petsc_coarse_solver->pc(),SOLVER_NAME);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+#endif
+
+  // U[n] is the state at the start of slice n, G_old[n] = G(U_{n-1}^k)
+  std::vector<NumericVector<Number>*> U(n_slices+1);
+  std::vector<NumericVector<Number>*> G_old(n_slices+1);
+  std::vector<NumericVector<Number>*> F_old(n_slices+1);
+  for (unsigned int n=0; n<=n_slices; n++)
+  {
+    U[n] = system.solution->clone().release();
+    G_old[n] = system.solution->clone().release();
+    F_old[n] = system.solution->clone().release();
+  }
+
+  for (unsigned int i=0; i<solutions.size(); i++)
+    delete solutions[i];
+  solutions.resize(n_timesteps);
+  for (unsigned int i=0; i<n_timesteps; i++)
+    solutions[i] = system.solution->clone().release();
+
+  Real time_coarse = 0.;
+  Real time_fine = 0.;
+  Real time_exchange = 0.;
+  unsigned int n_coarse = 0;
+  unsigned int n_fine = 0;
+
+  const Real start_solve = parareal_wall_time();
+
+  // Initial coarse sweep
+  Real start = parareal_wall_time();
+  for (unsigned int n=0; n<n_slices; n++)
+  {
+    propagate(es, system_name, *U[n], n*dt_coarse, dt_coarse, 1, coarse_solver.get(), NULL);
+    *G_old[n+1] = *system.solution;
+    *U[n+1] = *system.solution;
+    n_coarse++;
+  }
+  time_coarse += parareal_wall_time()-start;
+
+  std::vector<NumericVector<Number>*> slice_steps;
+  unsigned int k = 0;
+  for (k=1; k<=n_slices; k++)
+  {
+    // Fine sweep, independent for every slice, the slices of this group
+    start = parareal_wall_time();
+    for (unsigned int n=group; n<n_slices; n+=n_groups)
+    {
+      propagate(es, system_name, *U[n], n*dt_coarse, dt_fine, m, NULL, &slice_steps);
+      *F_old[n+1] = *system.solution;
+      n_fine += m;
+
+      for (unsigned int j=0; j<m; j++)
+      {
+        delete solutions[n*m+j];
+        solutions[n*m+j] = slice_steps[j];
+      }
+      slice_steps.clear();
+    }
+    time_fine += parareal_wall_time()-start;
+
+    start = parareal_wall_time();
+    if (n_groups > 1)
+      for (unsigned int n=0; n<n_slices; n++)
+        parareal_broadcast(*F_old[n+1], n % n_groups);
+    time_exchange += parareal_wall_time()-start;
+
+    // Sequential coarse correction, the same on every group
+    Real change = 0.;
+    start = parareal_wall_time();
+    for (unsigned int n=0; n<n_slices; n++)
+    {
+      propagate(es, system_name, *U[n], n*dt_coarse, dt_coarse, 1, coarse_solver.get(), NULL);
+      n_coarse++;
+
+      AutoPtr<NumericVector<Number> > U_new = system.solution->clone();
+      U_new->add(1., *F_old[n+1]);
+      U_new->add(-1., *G_old[n+1]);
+      *G_old[n+1] = *system.solution;
+
+      AutoPtr<NumericVector<Number> > diff = U_new->clone();
+      diff->add(-1., *U[n+1]);
+      change = std::max(change, diff->l2_norm()/std::max(U_new->l2_norm(), 1.e-12));
+
+      *U[n+1] = *U_new;
+    }
+    time_coarse += parareal_wall_time()-start;
+
+    std::cout<<"Parareal iteration "<< k <<", change "<< change <<std::endl;
+
+    // The first k slices are exact after k iterations
+    if ( (change < tol) || (k == n_slices) )
+      break;
+  }
+
+  // The fine steps of the last sweep, for the replay
+  start = parareal_wall_time();
+  if (n_groups > 1)
+    for (unsigned int i=0; i<n_timesteps; i++)
+      parareal_broadcast(*solutions[i], (i/m) % n_groups);
+  time_exchange += parareal_wall_time()-start;
+
+  // Measured wall time against n_timesteps fine steps at the measured
+  // cost of one, the sequential time stepping of the same accuracy
+  const Real t_parareal = parareal_wall_time()-start_solve;
+  const Real c_fine = time_fine/std::max(n_fine,1u);
+  const Real c_coarse = time_coarse/std::max(n_coarse,1u);
+  const Real t_serial = n_timesteps*c_fine;
+
+  std::cout<<"Parareal iterations "<< k <<std::endl;
+  std::cout<<"Parareal fine step "<< c_fine <<" s, coarse step "<< c_coarse <<" s, exchange "<< time_exchange <<" s"<<std::endl;
+  std::cout<<"Parareal wall time "<< t_parareal <<" s, speedup over "<< n_timesteps <<" fine steps "<< t_serial/t_parareal
+           <<" on "<< n_groups <<" groups"<<std::endl;
+
+  es.parameters.set<unsigned int>("parareal_iterations") = k;
+  es.parameters.set<Real>("parareal_speedup") = t_serial/t_parareal;
+
+  for (unsigned int n=0; n<=n_slices; n++)
+  {
+    delete U[n];
+    delete G_old[n];
+    delete F_old[n];
+  }
+
+  // Leave the system at the initial state for the replay in the time loop
+  system.solution->zero();
+  system.old_local_solution->zero();
+  system.older_local_solution->zero();
+  system.update();
+}
@@ -14,13 +14,13 @@ using namespace std;
 
 void read_parameters(EquationSystems& es,  int& argc, char**& argv){
 
-if (argc >2){
+if ((argc >2) && (argv[1][0] != '-')){
 		es.parameters.set<Real> ("n_timesteps") = atoi( argv[1] );
 		es.parameters.set<Real> ("N_eles") = atoi( argv[2] );
 		es.parameters.set<std::string> ("output_file_name") = argv[3] ;
 		es.parameters.set<std::string> ("result_file_name") =  argv[4] ;
 
-	if (argc >5){
+	if ((argc >5) && (argv[5][0] != '-')){
    es.parameters.set<Real> ("DELTA") = atof( argv[5] );
 	}else{
 	es.parameters.set<Real> ("DELTA") = 1;
@@ -36,12 +36,119 @@ if (argc >2){
 
 }
 
+  es.parameters.set<Real> ("end_time") = command_line_value("-end_time", 0.25);
+  const Real end_time = es.parameters.get<Real>("end_time");
+
+  //Adaptive time stepping, switched on by a positive -dt_tol
+  es.parameters.set<Real> ("dt_tol") = command_line_value("-dt_tol", 0.);
+  es.parameters.set<Real> ("dt_init") = command_line_value("-dt_init", end_time/es.parameters.get<Real>("n_timesteps"));
+  es.parameters.set<Real> ("dt_min") = command_line_value("-dt_min", 1.e-6*end_time);
+  es.parameters.set<Real> ("dt_max") = command_line_value("-dt_max", end_time);
+
+  //Time integrator of the mass equation, BE (backward Euler) or BDF2
+  es.parameters.set<std::string> ("time_scheme") = command_line_value("-time_scheme", std::string("BE"));
+  if ( (es.parameters.get<std::string>("time_scheme") != "BE") &&
+       (es.parameters.get<std::string>("time_scheme") != "BDF2") )
+  {
+    std::cerr<<"Unknown time_scheme "<< es.parameters.get<std::string>("time_scheme") <<", use BE or BDF2"<<std::endl;
+    libmesh_error();
+  }
+
+  //Parareal over -parareal_slices time slices, off for 0
+  es.parameters.set<unsigned int> ("parareal_slices") = command_line_value("-parareal_slices", 0);
+  es.parameters.set<Real> ("parareal_tol") = command_line_value("-parareal_tol", 1.e-8);
+  if (es.parameters.get<unsigned int>("parareal_slices") > 0)
+  {
+    const unsigned int n_timesteps = es.parameters.get<Real>("n_timesteps");
+    if ( (n_timesteps % es.parameters.get<unsigned int>("parareal_slices") != 0) ||
+         (es.parameters.get<Real>("dt_tol") > 0) ||
+         (es.parameters.get<std::string>("time_scheme") != "BE") )
+    {
+      std::cerr<<"Parareal needs fixed BE steps and parareal_slices dividing n_timesteps"<<std::endl;
+      libmesh_error();
+    }
+  }
+
+  //Concurrent fine propagation, see parareal.cpp
+  if ( (command_line_value("-parareal_groups", 1) > 1) &&
+       (es.parameters.get<unsigned int>("parareal_slices") == 0) )
+  {
+    std::cerr<<"parareal_groups needs parareal_slices"<<std::endl;
+    libmesh_error();
+  }
+
+  //All-at-once solve of the NT steps
+  es.parameters.set<bool> ("space_time") = on_command_line("-space_time");
+  if ( es.parameters.get<bool>("space_time") &&
+       ( (es.parameters.get<unsigned int>("parareal_slices") > 0) ||
+         (es.parameters.get<Real>("dt_tol") > 0) ||
+         (es.parameters.get<std::string>("time_scheme") != "BE") ) )
+  {
+    std::cerr<<"The space-time solve needs fixed BE steps"<<std::endl;
+    libmesh_error();
+  }
+  //Direct solve (lu) or GMRES with the alpha-circulant preconditioner (circulant)
+  es.parameters.set<std::string> ("space_time_pc") = command_line_value("-space_time_pc", std::string("lu"));
+  es.parameters.set<Real> ("space_time_alpha") = command_line_value("-space_time_alpha", 1.e-4);
+  if ( (es.parameters.get<std::string>("space_time_pc") != "lu") &&
+       (es.parameters.get<std::string>("space_time_pc") != "circulant") )
+  {
+    std::cerr<<"Unknown space_time_pc "<< es.parameters.get<std::string>("space_time_pc") <<", use lu or circulant"<<std::endl;
+    libmesh_error();
+  }
+
+  //Error norms by exact quadrature or from the projection on a higher order space
+  es.parameters.set<std::string> ("error_norms") = command_line_value("-error_norms", std::string("quadrature"));
+  if ( (es.parameters.get<std::string>("error_norms") != "quadrature") &&
+       (es.parameters.get<std::string>("error_norms") != "projection") )
+  {
+    std::cerr<<"Unknown error_norms "<< es.parameters.get<std::string>("error_norms") <<", use quadrature or projection"<<std::endl;
+    libmesh_error();
+  }
+
+  //Stiffness matrix for every dt from components assembled once
+  es.parameters.set<bool> ("affine_operators") = on_command_line("-affine_operators");
+
+  //Scale the variable blocks of the system to O(1) before each solve
+  es.parameters.set<bool> ("block_scaling") = on_command_line("-block_scaling");
 
   std::cout<<"n_timesteps "<< es.parameters.get<Real>("n_timesteps") <<" \n";
   std::cout<<"N_eles "<< es.parameters.get<Real>("N_eles") <<" \n";
   std::cout<<"output_file_name "<< es.parameters.get<std::string>("output_file_name") <<" \n";
   std::cout<<"result_file_name "<< es.parameters.get<std::string>("result_file_name") <<" \n";
     std::cout<<"DELTA "<< es.parameters.get<Real>("DELTA") <<" \n";
+  std::cout<<"time_scheme "<< es.parameters.get<std::string>("time_scheme") <<" \n";
+  if (es.parameters.get<bool>("space_time"))
+    std::cout<<"space_time "<< es.parameters.get<std::string>("space_time_pc") <<" \n";
+  if (es.parameters.get<bool>("affine_operators"))
+    std::cout<<"affine_operators \n";
+  if (es.parameters.get<bool>("block_scaling"))
+    std::cout<<"block_scaling \n";
+  std::cout<<"error_norms "<< es.parameters.get<std::string>("error_norms") <<" \n";
+  if (es.parameters.get<unsigned int>("parareal_slices") > 0)
+    std::cout<<"parareal_slices "<< es.parameters.get<unsigned int>("parareal_slices") <<" \n";
+  if (es.parameters.get<Real>("dt_tol") > 0)
+    std::cout<<"dt_tol "<< es.parameters.get<Real>("dt_tol") <<" \n";
+
+
+}
+
+
+// The values of a sweep option, e.g. -sweep_nt "8 16 32" or -sweep_nt 8,16,32,
+// empty when the option is not given
+std::vector<Real> read_sweep_values (const std::string& option)
+{
+  std::vector<Real> values;
+  if (!on_command_line(option))
+    return values;
+
+  std::string list = command_line_value(option, std::string());
+  std::replace(list.begin(), list.end(), ',', ' ');
 
+  std::istringstream stream(list);
+  Real value;
+  while (stream >> value)
+    values.push_back(value);
 
+  return values;
 }
@@ -0,0 +1,48 @@
+#!/bin/bash
+# Measured Parareal speedup at equal accuracy: the sequential time
+# stepping on NP processors against Parareal with SLICES slices on
+# SLICES groups of NP processors.  Both runs print their wall time and
+# write the error norms of the .mat table; with the default tolerance
+# Parareal converges to the sequential solution, so the norms agree and
+# the speedup is the ratio of the wall times.
+#
+#   scripts/run_parareal.sh [NP] [SLICES]
+
+NP=${1:-1}
+SLICES=${2:-4}
+
+f_prefix="2D_parareal"
+
+NE=32
+NT=64
+DELTA=1
+
+exe_directory="./"
+
+matfiles_dir="data/matfiles/"
+data_dir="data/"
+
+exe_filename="ex11-opt"
+
+mkdir -p $exe_directory$matfiles_dir
+
+base=$f_prefix"_NT_"$NT"_NE_"$NE
+
+exe_str="mpirun -np $NP $exe_directory$exe_filename $NT $NE $exe_directory$matfiles_dir$base"_serial.mat" $exe_directory$data_dir$base"_serial" $DELTA"
+   echo $exe_str
+start=$(date +%s.%N)
+$exe_str > $exe_directory$data_dir$base"_serial.log"
+end=$(date +%s.%N)
+t_serial=$(echo "$end - $start" | bc)
+
+exe_str="mpirun -np $((NP*SLICES)) $exe_directory$exe_filename $NT $NE $exe_directory$matfiles_dir$base"_parareal.mat" $exe_directory$data_dir$base"_parareal" $DELTA -parareal_slices $SLICES -parareal_groups $SLICES"
+   echo $exe_str
+start=$(date +%s.%N)
+$exe_str > $exe_directory$data_dir$base"_parareal.log"
+end=$(date +%s.%N)
+t_parareal=$(echo "$end - $start" | bc)
+
+echo "errors, sequential: "$(cat $exe_directory$matfiles_dir$base"_serial.mat")
+echo "errors, parareal:   "$(cat $exe_directory$matfiles_dir$base"_parareal.mat")
+grep "^Parareal" $exe_directory$data_dir$base"_parareal.log"
+echo "wall time, sequential $t_serial s, parareal $t_parareal s, speedup "$(echo "$t_serial / $t_parareal" | bc -l)
@@ -0,0 +1,39 @@
+#!/bin/bash
+# Throughput of the space-time solve against the number of processors,
+# the direct solve (-space_time_pc lu) and GMRES with the alpha-circulant
+# preconditioner (-space_time_pc circulant).  Every run prints
+#   Space-time solve (<pc>) on <NP> processors: <its> iterations, <s> s, <unknowns/s> unknowns/s
+# and the error norms of the .mat table, which agree between the two.
+
+f_prefix="2D_space_time"
+
+NE=32
+NT=64
+DELTA=1
+PROCS=(1 2 4 8 16)
+
+exe_directory="./"
+
+matfiles_dir="data/matfiles/"
+data_dir="data/"
+
+exe_filename="ex11-opt"
+
+mkdir -p $exe_directory$matfiles_dir
+
+for pc in lu circulant
+do
+for np in ${PROCS[@]}
+do
+
+base=$f_prefix"_"$pc"_NP_"$np"_NT_"$NT"_NE_"$NE
+
+exe_str="mpirun -np $np $exe_directory$exe_filename $NT $NE $exe_directory$matfiles_dir$base"_.mat" $exe_directory$data_dir$base $DELTA -space_time -space_time_pc $pc"
+   echo $exe_str
+
+$exe_str > $exe_directory$data_dir$base".log"
+grep "^Space-time solve" $exe_directory$data_dir$base".log"
+cat $exe_directory$matfiles_dir$base"_.mat"
+
+done
+done
@@ -0,0 +1,22 @@
+#!/bin/bash
+# The sweep of run_sims.sh in one process: every mesh is set up once and
+# reused for all NT and DELTA, the errors of all runs go to one table
+# (n_timesteps N_eles and the five norms, DELTA as the last column)
+
+f_prefix="2D_stab"
+
+NE="8,16,32,64"
+NT="8,16,32,64"
+DELTA="10,100"
+
+exe_directory="/users/lorenzb/Dphil/libmesh_projetcs/poro_paper_sims/2D_convergence_delta2/"
+
+matfiles_dir="data/matfiles/"
+data_dir="data/"
+
+exe_filename="ex11-opt"
+
+exe_str="$exe_directory$exe_filename 0 0 $exe_directory$matfiles_dir$f_prefix"_sweep.mat" $exe_directory$data_dir$f_prefix -sweep_ne $NE -sweep_nt $NT -sweep_delta $DELTA"
+   echo $exe_str
+
+`$exe_str`
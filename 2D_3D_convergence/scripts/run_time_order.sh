@@ -0,0 +1,49 @@
+#!/bin/bash
+# Observed order in time of backward Euler and BDF2 (-time_scheme): one
+# sweep over NT at a fixed fine mesh per scheme, then the order of each
+# space-time error norm of the table (TIME 1 in assemble.h, the errors
+# accumulated over all steps), log(e_coarse/e_fine)/log(NT_fine/NT_coarse)
+# between successive NT.  NE must be fine enough that the spatial error
+# stays below the time error, otherwise the BDF2 order saturates at the
+# finest NT.
+
+f_prefix="2D_time_order"
+
+NE=64
+NT="4,8,16,32,64"
+DELTA=1
+
+exe_directory="./"
+
+matfiles_dir="data/matfiles/"
+data_dir="data/"
+
+exe_filename="ex11-opt"
+
+mkdir -p $exe_directory$matfiles_dir
+
+for scheme in BE BDF2
+do
+
+output_file_name_mat="$exe_directory$matfiles_dir$f_prefix"_"$scheme"_NE_"$NE"_.mat""
+
+exe_str="$exe_directory$exe_filename 4 $NE $output_file_name_mat $exe_directory$data_dir$f_prefix"_"$scheme $DELTA -sweep_nt $NT -time_scheme $scheme"
+   echo $exe_str
+
+`$exe_str`
+
+# Columns: n_timesteps N_eles, TL2 u, TH1 u, TL2 z, THdiv z, TL2 p, DELTA
+echo "$scheme observed order in time: NT  L2 u  H1 u  L2 z  Hdiv z  L2 p"
+awk '{
+  if (NR > 1) {
+    printf "%d", $1;
+    for (c=3; c<=7; c++)
+      printf "  %.2f", log(e[c]/$c)/log($1/nt);
+    printf "\n";
+  }
+  nt = $1;
+  for (c=3; c<=7; c++)
+    e[c] = $c;
+}' $output_file_name_mat
+
+done
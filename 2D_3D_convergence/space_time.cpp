@@ -0,0 +1,549 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "petsc_matrix.h"
+#include "petsc_vector.h"
+#include "petsc_macro.h"
+
+#include "assemble.h"
+
+// All-at-once solve of the NT backward Euler steps with constant dt,
+//
+//   [  K             ] [x^1 ]   [f^1]
+//   [ -H   K         ] [x^2 ] = [f^2]
+//   [      ...  ...  ] [... ]   [...]
+//   [           -H  K] [x^NT]   [f^NT]
+//
+// with K the stiffness matrix, H the history operator of assemble_rhs
+// (assemble_history.cpp) and f^n the rhs with zero history at t^n.
+//
+// Every process owns all the time levels of its own dofs, so the
+// space-time matrix is distributed like the spatial one.  With a nested
+// dissection ordering (METIS in MUMPS) the elimination of the block
+// chain is block cyclic reduction on the time axis: the NT steps are
+// eliminated in log2(NT) levels whose blocks are factorised concurrently
+// instead of one step after another.
+//
+// -space_time_pc circulant solves the system with GMRES instead,
+// preconditioned by the alpha-circulant matrix P (-space_time_alpha a,
+// default 1e-4): the wrap-around block a H added to the top right
+// corner.  P is diagonalised in time,
+//   P = (D V x I) blockdiag(K - lambda_j H) (V^-1 D^-1 x I),
+//   D = diag(a^(-n/NT)),  V the inverse DFT,
+//   lambda_j = a^(1/NT) exp(-2 pi i j/NT),
+// so applying P^-1 is a scaled DFT along the time axis, NT independent
+// complex spatial solves and the inverse transform.  The DFT acts on the
+// time levels of each dof and every process owns all the time levels
+// of its dofs, so it needs no communication.  For a real residual the
+// frequencies j and NT-j are conjugate, only j = 0..NT/2 are solved.
+// Their real equivalent blocks (2x2 per complex entry) form one block
+// diagonal matrix, factorised once;
+// its blocks are decoupled, so MUMPS factorises and solves them as
+// independent subtrees on different processes.  GMRES converges in a
+// few iterations for small a, the error of P is O(a).
+
+
+// Global space-time row of dof i at step n (0 based), "ranges" are the
+// ownership ranges of the spatial matrix.
+PetscInt space_time_index (const PetscInt* ranges, const unsigned int n_procs,
+                      const unsigned int n_timesteps, const unsigned int n, const PetscInt i)
+{
+  const unsigned int owner = std::upper_bound(ranges, ranges+n_procs+1, i) - ranges - 1;
+  const PetscInt n_local = ranges[owner+1]-ranges[owner];
+  return n_timesteps*ranges[owner] + n*n_local + (i-ranges[owner]);
+}
+
+
+// The alpha-circulant preconditioner: the factorised frequency blocks,
+// their work vectors and the DFT tables cos/sin(2 pi n/N) and a^(n/N)
+struct CirculantPC
+{
+  unsigned int n_timesteps;
+  unsigned int n_freq;
+  PetscInt n_local;
+  Real alpha;
+  std::vector<Real> cos_table, sin_table, scale;
+  Vec z, w;
+  KSP ksp;
+};
+
+
+// x = P^-1 r
+PetscErrorCode apply_circulant_pc (PC pc, Vec r, Vec x)
+{
+  void* context;
+  int ierr = PCShellGetContext(pc, &context);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  const CirculantPC& circulant = *static_cast<CirculantPC*>(context);
+
+  const unsigned int N = circulant.n_timesteps;
+  const PetscInt n_local = circulant.n_local;
+  const std::vector<Real>& cos_table = circulant.cos_table;
+  const std::vector<Real>& sin_table = circulant.sin_table;
+  const std::vector<Real>& scale = circulant.scale;
+
+  // The transforms are plain O(NT^2) sums per dof, no FFT library is
+  // linked.  NT is a few hundred steps at most, so they cost little next
+  // to the block solve.
+  // z_j = 1/N sum_n exp(-2 pi i j n/N) a^(n/N) r_n
+  PetscScalar *r_array, *z_array;
+  ierr = VecGetArray(r, &r_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecGetArray(circulant.z, &z_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  for (PetscInt l=0; l<n_local; l++)
+    for (unsigned int j=0; j<circulant.n_freq; j++)
+    {
+      Real z_real = 0., z_imag = 0.;
+      for (unsigned int n=0; n<N; n++)
+      {
+        const Real s = scale[n]*r_array[n*n_local + l];
+        z_real += s*cos_table[(j*n) % N];
+        z_imag -= s*sin_table[(j*n) % N];
+      }
+      z_array[j*2*n_local + 2*l]   = z_real/N;
+      z_array[j*2*n_local + 2*l+1] = z_imag/N;
+    }
+  ierr = VecRestoreArray(circulant.z, &z_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecRestoreArray(r, &r_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  // (K - lambda_j H) w_j = z_j for all j at once
+  ierr = KSPSolve(circulant.ksp, circulant.z, circulant.w);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  // x_n = a^(-n/N) sum_j Re(exp(2 pi i j n/N) w_j), j and N-j together
+  PetscScalar *w_array, *x_array;
+  ierr = VecGetArray(circulant.w, &w_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecGetArray(x, &x_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  for (PetscInt l=0; l<n_local; l++)
+    for (unsigned int n=0; n<N; n++)
+    {
+      Real y = 0.;
+      for (unsigned int j=0; j<circulant.n_freq; j++)
+      {
+        const Real weight = ( (j == 0) || (2*j == N) ) ? 1. : 2.;
+        y += weight*(w_array[j*2*n_local + 2*l]*cos_table[(j*n) % N] -
+                     w_array[j*2*n_local + 2*l+1]*sin_table[(j*n) % N]);
+      }
+      x_array[n*n_local + l] = y/scale[n];
+    }
+  ierr = VecRestoreArray(x, &x_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecRestoreArray(circulant.w, &w_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  return 0;
+}
+
+
+// Builds and factorises the block diagonal matrix of the frequency
+// blocks K - lambda_j H, j = 0..NT/2, in real equivalent form,
+//   [ K - Re(lambda) H    Im(lambda) H     ]
+//   [ -Im(lambda) H       K - Re(lambda) H ]
+// with the real and imaginary part of every dof interleaved.  Every
+// process owns the frequencies of its own dofs.
+void setup_circulant_pc (Mat K, Mat H, const PetscInt* ranges, const unsigned int n_procs,
+                      CirculantPC& circulant)
+{
+  const unsigned int N = circulant.n_timesteps;
+  const unsigned int n_freq = circulant.n_freq;
+  const PetscInt first = ranges[libMesh::processor_id()];
+  const PetscInt last = ranges[libMesh::processor_id()+1];
+  const PetscInt n_local = last-first;
+  const PetscInt n_global = ranges[n_procs];
+  const PetscInt size_local = 2*n_freq*n_local;
+
+  circulant.cos_table.resize(N);
+  circulant.sin_table.resize(N);
+  circulant.scale.resize(N);
+  for (unsigned int n=0; n<N; n++)
+  {
+    circulant.cos_table[n] = cos(2.*libMesh::pi*n/N);
+    circulant.sin_table[n] = sin(2.*libMesh::pi*n/N);
+    circulant.scale[n] = pow(circulant.alpha, Real(n)/N);
+  }
+
+  // Each row holds the K and H columns of the dof for both parts
+  std::vector<PetscInt> d_nnz(size_local, 0);
+  std::vector<PetscInt> o_nnz(size_local, 0);
+  int ierr;
+  for (unsigned int m=0; m<2; m++)
+  {
+    Mat block = (m == 0) ? K : H;
+    for (PetscInt i=first; i<last; i++)
+    {
+      PetscInt ncols;
+      const PetscInt* row_cols;
+      ierr = MatGetRow(block, i, &ncols, &row_cols, PETSC_NULL);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      PetscInt n_diag = 0;
+      for (PetscInt j=0; j<ncols; j++)
+        if ((row_cols[j] >= first) && (row_cols[j] < last))
+          n_diag++;
+      for (unsigned int j=0; j<n_freq; j++)
+        for (unsigned int c=0; c<2; c++)
+        {
+          d_nnz[j*2*n_local + 2*(i-first) + c] += 2*n_diag;
+          o_nnz[j*2*n_local + 2*(i-first) + c] += 2*(ncols-n_diag);
+        }
+      ierr = MatRestoreRow(block, i, &ncols, &row_cols, PETSC_NULL);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    }
+  }
+
+  Mat M;
+  ierr = MatCreate(libMesh::COMM_WORLD, &M);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSetSizes(M, size_local, size_local, 2*n_freq*n_global, 2*n_freq*n_global);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSetType(M, MATAIJ);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSeqAIJSetPreallocation(M, 0, &d_nnz[0]);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatMPIAIJSetPreallocation(M, 0, &d_nnz[0], 0, &o_nnz[0]);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  const Real alpha_root = pow(circulant.alpha, 1./N);
+  std::vector<PetscInt> cols;
+  std::vector<PetscScalar> real_row, imag_row;
+  for (unsigned int m=0; m<2; m++)
+  {
+    Mat block = (m == 0) ? K : H;
+    for (PetscInt i=first; i<last; i++)
+    {
+      PetscInt ncols;
+      const PetscInt* row_cols;
+      const PetscScalar* row_vals;
+      ierr = MatGetRow(block, i, &ncols, &row_cols, &row_vals);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      cols.resize(2*ncols);
+      real_row.resize(2*ncols);
+      imag_row.resize(2*ncols);
+      for (unsigned int j=0; j<n_freq; j++)
+      {
+        const Real lambda_real = alpha_root*circulant.cos_table[j];
+        const Real lambda_imag = -alpha_root*circulant.sin_table[j];
+        for (PetscInt k=0; k<ncols; k++)
+        {
+          const PetscInt col = 2*space_time_index(ranges, n_procs, n_freq, j, row_cols[k]);
+          cols[2*k] = col;
+          cols[2*k+1] = col+1;
+          if (m == 0)
+          {
+            real_row[2*k] = row_vals[k];  real_row[2*k+1] = 0.;
+            imag_row[2*k] = 0.;           imag_row[2*k+1] = row_vals[k];
+          }
+          else
+          {
+            real_row[2*k] = -lambda_real*row_vals[k];  real_row[2*k+1] = lambda_imag*row_vals[k];
+            imag_row[2*k] = -lambda_imag*row_vals[k];  imag_row[2*k+1] = -lambda_real*row_vals[k];
+          }
+        }
+        const PetscInt real_index = 2*space_time_index(ranges, n_procs, n_freq, j, i);
+        const PetscInt imag_index = real_index+1;
+        if (ncols > 0)
+        {
+          ierr = MatSetValues(M, 1, &real_index, 2*ncols, &cols[0], &real_row[0], ADD_VALUES);
+          CHKERRABORT(libMesh::COMM_WORLD,ierr);
+          ierr = MatSetValues(M, 1, &imag_index, 2*ncols, &cols[0], &imag_row[0], ADD_VALUES);
+          CHKERRABORT(libMesh::COMM_WORLD,ierr);
+        }
+      }
+      ierr = MatRestoreRow(block, i, &ncols, &row_cols, &row_vals);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  ierr = VecCreateMPI(libMesh::COMM_WORLD, size_local, 2*n_freq*n_global, &circulant.z);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecDuplicate(circulant.z, &circulant.w);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  PC pc;
+  ierr = KSPCreate(libMesh::COMM_WORLD, &circulant.ksp);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPSetOperators(circulant.ksp, M, M, DIFFERENT_NONZERO_PATTERN);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPSetType(circulant.ksp, KSPPREONLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPGetPC(circulant.ksp, &pc);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = PCSetType(pc, PC_TYPE);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = PCFactorSetMatSolverPackage(pc, SOLVER_NAME);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPSetUp(circulant.ksp);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  // The KSP keeps its reference
+  ierr = LibMeshMatDestroy(&M);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+}
+
+
+// Fills "solutions" with the solution after every step (owned by the
+// caller).
+void space_time_solve (EquationSystems& es, const std::string& system_name,
+                      std::vector<NumericVector<Number>*>& solutions)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  PerfLog perf_log("Space-time solve");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int n_timesteps = es.parameters.get<Real>("n_timesteps");
+  const Real dt = es.parameters.get<Real>("dt");
+  const unsigned int n_procs = libMesh::n_processors();
+
+  PetscMatrix<Number>* petsc_matrix = dynamic_cast<PetscMatrix<Number>*>(system.matrix);
+  PetscMatrix<Number>* petsc_history = dynamic_cast<PetscMatrix<Number>*>(&system.get_matrix("history"));
+  PetscVector<Number>* petsc_rhs = dynamic_cast<PetscVector<Number>*>(system.rhs);
+
+  // Spatial operators
+  perf_log.push("assemble");
+  es.parameters.set<Real>("time") = dt;
+  system.matrix->zero();
+  assemble_stiffness(es,system_name);
+  assemble_history(es,system_name,system.get_matrix("history"));
+  perf_log.pop("assemble");
+
+  const PetscInt* ranges;
+  int ierr = MatGetOwnershipRanges(petsc_matrix->mat(), &ranges);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  const PetscInt first = ranges[libMesh::processor_id()];
+  const PetscInt last = ranges[libMesh::processor_id()+1];
+  const PetscInt n_local = last-first;
+  const PetscInt n_global = ranges[n_procs];
+
+  // Rhs of every step with zero history
+  perf_log.push("rhs");
+  Vec b, x;
+  ierr = VecCreateMPI(libMesh::COMM_WORLD, n_timesteps*n_local, n_timesteps*n_global, &b);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecDuplicate(b, &x);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  system.old_local_solution->zero();
+  for (unsigned int n=0; n<n_timesteps; n++)
+  {
+    es.parameters.set<Real>("time") = (n+1)*dt;
+    es.parameters.set<unsigned int>("step") = n+1;
+    system.rhs->zero();
+    assemble_rhs(es,system_name);
+
+    PetscScalar *b_array, *rhs_array;
+    ierr = VecGetArray(b, &b_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = VecGetArray(petsc_rhs->vec(), &rhs_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    for (PetscInt l=0; l<n_local; l++)
+      b_array[n*n_local + l] = rhs_array[l];
+    ierr = VecRestoreArray(petsc_rhs->vec(), &rhs_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = VecRestoreArray(b, &b_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+  perf_log.pop("rhs");
+
+  // Block bidiagonal matrix
+  perf_log.push("build");
+  std::vector<PetscInt> d_nnz(n_timesteps*n_local, 0);
+  std::vector<PetscInt> o_nnz(n_timesteps*n_local, 0);
+  for (unsigned int m=0; m<2; m++)
+  {
+    Mat block = (m == 0) ? petsc_matrix->mat() : petsc_history->mat();
+    for (PetscInt i=first; i<last; i++)
+    {
+      PetscInt ncols;
+      const PetscInt* row_cols;
+      ierr = MatGetRow(block, i, &ncols, &row_cols, PETSC_NULL);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      PetscInt n_diag = 0;
+      for (PetscInt j=0; j<ncols; j++)
+        if ((row_cols[j] >= first) && (row_cols[j] < last))
+          n_diag++;
+      for (unsigned int n=m; n<n_timesteps; n++)
+      {
+        d_nnz[n*n_local + i-first] += n_diag;
+        o_nnz[n*n_local + i-first] += ncols-n_diag;
+      }
+      ierr = MatRestoreRow(block, i, &ncols, &row_cols, PETSC_NULL);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    }
+  }
+
+  Mat A;
+  ierr = MatCreate(libMesh::COMM_WORLD, &A);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSetSizes(A, n_timesteps*n_local, n_timesteps*n_local, n_timesteps*n_global, n_timesteps*n_global);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSetType(A, MATAIJ);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSeqAIJSetPreallocation(A, 0, &d_nnz[0]);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatMPIAIJSetPreallocation(A, 0, &d_nnz[0], 0, &o_nnz[0]);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  std::vector<PetscInt> st_cols;
+  std::vector<PetscScalar> st_vals;
+  for (unsigned int m=0; m<2; m++)
+  {
+    Mat block = (m == 0) ? petsc_matrix->mat() : petsc_history->mat();
+    const PetscScalar sign = (m == 0) ? 1. : -1.;
+    for (PetscInt i=first; i<last; i++)
+    {
+      PetscInt ncols;
+      const PetscInt* row_cols;
+      const PetscScalar* row_vals;
+      ierr = MatGetRow(block, i, &ncols, &row_cols, &row_vals);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      st_cols.resize(ncols);
+      st_vals.resize(ncols);
+      for (unsigned int n=m; n<n_timesteps; n++)
+      {
+        // K couples step n to itself, H to step n-1
+        PetscInt st_row = space_time_index(ranges, n_procs, n_timesteps, n, i);
+        for (PetscInt j=0; j<ncols; j++)
+        {
+          st_cols[j] = space_time_index(ranges, n_procs, n_timesteps, n-m, row_cols[j]);
+          st_vals[j] = sign*row_vals[j];
+        }
+        if (ncols > 0)
+        {
+          ierr = MatSetValues(A, 1, &st_row, ncols, &st_cols[0], &st_vals[0], ADD_VALUES);
+          CHKERRABORT(libMesh::COMM_WORLD,ierr);
+        }
+      }
+      ierr = MatRestoreRow(block, i, &ncols, &row_cols, &row_vals);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  perf_log.pop("build");
+
+  std::cout<<"Space-time system of "<< n_timesteps <<" steps, "<< n_timesteps*n_global <<" unknowns"<<std::endl;
+
+  // One direct solve for all the steps, or GMRES with the
+  // alpha-circulant preconditioner
+  const bool circulant_pc = (es.parameters.get<std::string>("space_time_pc") == "circulant");
+  const Real start = MPI_Wtime();
+
+  CirculantPC circulant;
+  KSP ksp;
+  PC pc;
+  ierr = KSPCreate(libMesh::COMM_WORLD, &ksp);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPSetOperators(ksp, A, A, DIFFERENT_NONZERO_PATTERN);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPGetPC(ksp, &pc);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  if (circulant_pc)
+  {
+    perf_log.push("circulant setup");
+    circulant.n_timesteps = n_timesteps;
+    circulant.n_freq = n_timesteps/2 + 1;
+    circulant.n_local = n_local;
+    circulant.alpha = es.parameters.get<Real>("space_time_alpha");
+    setup_circulant_pc(petsc_matrix->mat(), petsc_history->mat(), ranges, n_procs, circulant);
+    perf_log.pop("circulant setup");
+
+    ierr = KSPSetType(ksp, KSPGMRES);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = KSPSetTolerances(ksp, es.parameters.get<Real>("linear solver tolerance"), PETSC_DEFAULT, PETSC_DEFAULT,
+                            es.parameters.get<unsigned int>("linear solver maximum iterations"));
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = PCSetType(pc, PCSHELL);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = PCShellSetApply(pc, apply_circulant_pc);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = PCShellSetContext(pc, &circulant);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+  else
+  {
+    ierr = KSPSetType(ksp, KSPPREONLY);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = PCSetType(pc, PC_TYPE);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = PCFactorSetMatSolverPackage(pc, SOLVER_NAME);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+
+  perf_log.push("solve");
+  ierr = KSPSolve(ksp, b, x);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  perf_log.pop("solve");
+
+  // Unknowns (dofs times steps) solved per second, for the scaling runs
+  PetscInt n_iterations;
+  ierr = KSPGetIterationNumber(ksp, &n_iterations);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  const Real seconds = MPI_Wtime()-start;
+  std::cout<<"Space-time solve ("<< es.parameters.get<std::string>("space_time_pc") <<") on "<< n_procs <<" processors: "
+           << n_iterations <<" iterations, "<< seconds <<" s, "<< n_timesteps*n_global/seconds <<" unknowns/s"<<std::endl;
+
+  // Split into the solutions of the steps
+  PetscScalar *x_array;
+  ierr = VecGetArray(x, &x_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  solutions.resize(n_timesteps);
+  for (unsigned int n=0; n<n_timesteps; n++)
+  {
+    solutions[n] = system.solution->clone().release();
+    PetscVector<Number>* petsc_step = dynamic_cast<PetscVector<Number>*>(solutions[n]);
+
+    PetscScalar *step_array;
+    ierr = VecGetArray(petsc_step->vec(), &step_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    for (PetscInt l=0; l<n_local; l++)
+      step_array[l] = x_array[n*n_local + l];
+    ierr = VecRestoreArray(petsc_step->vec(), &step_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    solutions[n]->close();
+  }
+  ierr = VecRestoreArray(x, &x_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  ierr = LibMeshKSPDestroy(&ksp);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  if (circulant_pc)
+  {
+    ierr = LibMeshKSPDestroy(&circulant.ksp);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = LibMeshVecDestroy(&circulant.z);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = LibMeshVecDestroy(&circulant.w);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+  ierr = LibMeshMatDestroy(&A);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshVecDestroy(&b);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshVecDestroy(&x);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+}
@@ -0,0 +1,113 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "linear_solver.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+
+#include "assemble.h"
+
+
+// Solve one step from old_local_solution to time "time" with step "dt".
+// The stiffness matrix only depends on dt, so it is reassembled (and
+// the solver refactorised) only when dt differs from the dt it was
+// last assembled with.  With -affine_operators the new matrix is
+// combined from the stored components without a pass over the mesh.
+//
+// With time_scheme BDF2 the mass equation
+//   (a0 div u^{n+1} + a1 div u^n + a2 div u^{n-1})/dt + div z^{n+1} = f
+// is divided by a0, which is backward Euler with the effective step
+// dt/a0 and the history c1 div u^n + c2 div u^{n-1} on the rhs.  The
+// first step has no u^{n-1} and is taken with backward Euler.
+void advance_time_step (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const Real dt_step = es.parameters.get<Real>("dt");
+
+  Real bdf_c1 = 1.;
+  Real bdf_c2 = 0.;
+  Real a0 = 1.;
+  if ( (es.parameters.get<std::string>("time_scheme") == "BDF2") &&
+       (es.parameters.get<unsigned int>("step") > 1) )
+  {
+    // Variable step BDF2 coefficients, w = dt_n/dt_{n-1}
+    const Real w = dt_step/es.parameters.get<Real>("dt_old");
+    a0 = (1.+2.*w)/(1.+w);
+    bdf_c1 = (1.+w)*(1.+w)/(1.+2.*w);
+    bdf_c2 = -w*w/(1.+2.*w);
+  }
+  es.parameters.set<Real>("bdf_c1") = bdf_c1;
+  es.parameters.set<Real>("bdf_c2") = bdf_c2;
+
+  // The assembly (and the forcing term) only see the effective step
+  const Real dt = dt_step/a0;
+  es.parameters.set<Real>("dt") = dt;
+
+  bool new_matrix = true;
+  if (es.parameters.have_parameter<Real>("assembled_dt"))
+    new_matrix = (es.parameters.get<Real>("assembled_dt") != dt);
+
+  if (new_matrix)
+  {
+    std::cout<<"Assemble stiffness for dt = "<< dt <<std::endl;
+    update_stiffness(es,system_name);
+    es.parameters.set<Real>("assembled_dt") = dt;
+    es.parameters.set<bool>("block_scaling_ready") = false;
+  }
+
+  // Keep the factorisation from the previous solve while the matrix is unchanged
+  system.get_linear_solver()->same_preconditioner = !new_matrix;
+
+  system.rhs->zero();
+  assemble_rhs(es,system_name);
+  system.update();
+  const bool block_scaling = es.parameters.get<bool>("block_scaling");
+  if (block_scaling)
+    apply_block_scaling(es,system_name);
+  system.solve();
+  if (block_scaling)
+    remove_block_scaling(es,system_name);
+
+  es.parameters.set<Real>("dt") = dt_step;
+}
+
+
+// Local truncation error of the backward Euler step, from the difference
+// between the new solution and the linear extrapolation of the last two:
+//   LTE ~ dt^2/2 u'' ~ dt/(dt+dt_old) * (u^{n+1} - u^n - dt/dt_old (u^n - u^{n-1}))
+// Returned relative to the size of the new solution.  With BDF2 this is
+// the error of the first order scheme, so the step control is conservative.
+Real estimate_time_error (EquationSystems& es,
+                      const std::string& system_name, const Real dt, const Real dt_old)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const Real ratio = dt/dt_old;
+
+  AutoPtr<NumericVector<Number> > lte = system.current_local_solution->clone();
+  lte->add(-(1.+ratio), *system.old_local_solution);
+  lte->add(ratio, *system.older_local_solution);
+  lte->scale(dt/(dt+dt_old));
+
+  const Real size = std::max(system.current_local_solution->l2_norm(), 1.e-12);
+
+  return lte->l2_norm()/size;
+}
@@ -96,6 +96,12 @@ void assemble_stiffness (EquationSystems& es,
 void assemble_rhs (EquationSystems& es,
                       const std::string& system_name);
 
+void assemble_stabilisation (EquationSystems& es,
+                      const std::string& system_name);
+
+void add_stabilisation_rhs (EquationSystems& es,
+                      const std::string& system_name);
+
 void assemble_error(Real& H1_semi_error_disp, Real& Hdiv_semi_error_vel, Real& L2_error_press,Real& L2_error_displacement,Real& L2_error_velocity,  EquationSystems& es,
                       const std::string& system_name);
 
@@ -104,6 +110,31 @@ void read_options(unsigned int &  n_timesteps, unsigned int &  N_eles, std::stri
 
 void read_parameters(EquationSystems& es, int& argc, char**& argv) ;
 
+// Boundary rows found once by build_boundary_dofs
+struct BoundaryDofs
+{
+  std::vector<int> rows;
+
+  std::vector<int> pressure_rows;
+  std::vector<const Node*> pressure_nodes;
+};
+
+extern BoundaryDofs boundary_dofs;
+
+void build_boundary_dofs (EquationSystems& es,
+                      const std::string& system_name);
+
+void export_system (EquationSystems& es,
+                      const std::string& system_name, const unsigned int t_step);
+
+Real wall_time ();
+
+void open_metrics (EquationSystems& es, const std::vector<std::string>& columns);
+
+void write_metrics (const std::vector<Real>& row);
+
+void close_metrics ();
+
 
 
 void test(int a);
@@ -157,66 +157,7 @@ Real alpha=0.93;
 } // end qp
 
 
-//Pressure jump stabilisation.
-#if USE_STAB  
- 	std::vector<unsigned int> stab_dofs_cols2;
-	std::vector<Real> stab_dofs_vals2;
-
-
-	std::vector<Real> stab_dofs_vals_rhs;
-
-    for (unsigned int s=0; s<elem->n_sides(); s++)
-    {
-      if (elem->neighbor(s) == NULL)
-      {   
-				//Only do something on the interior edges.
-      } //if (elem->neighbor(s) == NULL)
-			else{
-
-      const Elem* neighbor = elem->neighbor(s);
-
-			std::vector<unsigned int> neighbor_dof_indices_p;
-      dof_map.dof_indices(neighbor, neighbor_dof_indices_p,p_var);
-      const unsigned int n_neighbor_dofs_p = neighbor_dof_indices_p.size();
-
-			Real hmax=(*elem).hmax();
-      Real hmin=(*elem).hmin();
-
-			Real delta=pow(dt,delta_power)*PEN_STAB;
-      #if !THREED
-			Real factor=-delta*(hmax)*(hmax);;
-      #endif
-      
-      #if THREED
-      Real factor=-delta*(hmax*hmax*hmax);
-      #endif
-
-			//Accumulate RHS
-			std::vector< Real > p_old;
-			system.old_local_solution->get(dof_indices_p,p_old);
-			std::vector< Real > p_old_n;
-			system.old_local_solution->get(neighbor_dof_indices_p,p_old_n);
-      
-			stab_dofs_vals_rhs.push_back(-p_old[0]*factor);
-			stab_dofs_vals_rhs.push_back(p_old_n[0]*factor);
-      //perf_log.pop("push back");
-
-			}
-		}
-
-
-//add rhs
-DenseVector<Number> rhs_stab;
-rhs_stab.resize(dof_indices_p.size());
- 	
-for (int i=0; i < stab_dofs_vals_rhs.size(); i++) {
-	 	rhs_stab(0)+=stab_dofs_vals_rhs[i];
-	}
-
-std::vector<unsigned int> stab_dofs_rows_rhs;
-stab_dofs_rows_rhs.push_back(dof_indices_p[0]);
-system.rhs->add_vector(rhs_stab, stab_dofs_rows_rhs);
-  #endif 
+//Pressure jump stabilisation, S*p_old after the element loop (stabilisation.cpp)
 
 #if THREED
 //  #include "assemble_stokes_bcs_p1p1p0_anal_sine.cpp"
@@ -227,9 +168,8 @@ system.rhs->add_vector(rhs_stab, stab_dofs_rows_rhs);
   #if !THREED
 
 //  #include "assemble_stokes_bcs_p1p1p0_anal_sine.cpp"
-//  #include "square_pin_pressure.cpp"
+//  #include "square_pin_pressure.cpp" (after the element loop)
 //  	#include "cube_squash_bcs.cpp"
-#include "canteliver_bcs.cpp"
 #include "canteliver_traction_bcs.cpp"
 #endif
 
@@ -238,8 +178,17 @@ system.rhs->add_vector(rhs_stab, stab_dofs_rows_rhs);
 
 } // end of element loop
   
-	//Apply BCS
     system.rhs->close();
+
+  #if USE_STAB
+    add_stabilisation_rhs(es,system_name);
+  #endif
+
+  #if !THREED
+  #include "canteliver_bcs.cpp"
+  #endif
+
+	//Apply BCS
     system.matrix->zero_rows(rows, 1.0);
     for (int i=0; i < rows.size(); i++) {
       system.rhs->set(rows[i],rows_values[i]);
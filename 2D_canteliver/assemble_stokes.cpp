@@ -634,7 +634,7 @@ system.rhs->add_vector(rhs_stab, stab_dofs_rows_rhs);
   #include "assemble_stokes_bcs_p1p1p0_anal_sine.cpp"
   //#include "cube_squash_bcs.cpp"
 
-  #include "square_pin_pressure.cpp"
+  //square_pin_pressure.cpp after the element loop
   //apply zero pressure using nitsche's method
   //#include "nitsche_fluid_square_bcs.cpp"
   #endif
@@ -685,6 +685,10 @@ Fp(i)=res_mult(0,i);
 
 
 } // end of element loop
+
+  #if USE_STAB && !THREED
+  #include "square_pin_pressure.cpp"
+  #endif
   
     system.matrix->close();
     system.rhs->close();
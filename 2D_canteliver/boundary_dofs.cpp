@@ -0,0 +1,113 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "dof_map.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "elem.h"
+
+#include "assemble.h"
+
+// Dirichlet rows of the cantilever (canteliver_bcs.cpp) and the pinned
+// pressure of the square (square_pin_pressure.cpp).  The geometric search
+// over the boundary sides runs once after equation_systems.init() instead
+// of in every assembly, and every dof appears once.
+BoundaryDofs boundary_dofs;
+
+
+void build_boundary_dofs (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int u_var = system.variable_number ("s_u");
+  const unsigned int v_var = system.variable_number ("s_v");
+  #if THREED
+  const unsigned int w_var = system.variable_number ("s_w");
+  #endif
+  const unsigned int p_var = system.variable_number ("s_p");
+  const unsigned int x_var = system.variable_number ("x");
+  const unsigned int y_var = system.variable_number ("y");
+
+  boundary_dofs.rows.clear();
+  boundary_dofs.pressure_rows.clear();
+  boundary_dofs.pressure_nodes.clear();
+
+  std::set<unsigned int> seen;
+  std::set<unsigned int> seen_pressure;
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+
+    for (unsigned int s=0; s<elem->n_sides(); s++)
+    {
+      if (elem->neighbor(s) != NULL)
+        continue;
+
+      AutoPtr<Elem> side (elem->build_side(s));
+
+      for (unsigned int ns=0; ns<side->n_nodes(); ns++)
+      {
+        const Node* node = side->get_node(ns);
+        const Real xf = (*node)(0);
+        const Real yf = (*node)(1);
+
+        std::vector<unsigned int> vars;
+
+        //Left side is fixed
+        if (xf<0.001)
+        {
+          vars.push_back(u_var);
+          vars.push_back(v_var);
+          #if THREED
+          vars.push_back(w_var);
+          #endif
+        }
+
+        //No outflow on all sides
+        if ((xf>0.999) || (xf<0.001))
+          vars.push_back(x_var);
+        if ((yf>0.999) || (yf<0.001))
+          vars.push_back(y_var);
+
+        for (unsigned int v=0; v<vars.size(); v++)
+        {
+          const unsigned int source_dof = node->dof_number(system.number(), vars[v], 0);
+          if ((source_dof != DofObject::invalid_id) && seen.insert(source_dof).second)
+            boundary_dofs.rows.push_back(source_dof);
+        }
+
+        // Pin the (P0) pressure of the elements at the origin
+        if ((xf<0.001) && (yf<0.001))
+        {
+          const unsigned int source_dof = elem->dof_number(system.number(), p_var, 0);
+          if ((source_dof != DofObject::invalid_id) && seen_pressure.insert(source_dof).second)
+          {
+            boundary_dofs.pressure_rows.push_back(source_dof);
+            boundary_dofs.pressure_nodes.push_back(node);
+          }
+        }
+      }
+    }
+  }
+
+  std::cout<<"Boundary dofs "<< boundary_dofs.rows.size() <<", pinned pressure dofs "<< boundary_dofs.pressure_rows.size() <<std::endl;
+}
@@ -1,6 +1,10 @@
 close all;
 clear all;
 load poro.mat;
+%Or the binary export of -export_matrices data/matrices/poro, the blocks
+%below are selected with var, see load_poro_bin.m
+%[A, var, names] = load_poro_bin('poro_1_K.bin');
+%B = load_poro_bin('poro_1_r.bin');
 whos
 
 %Nu Number of p1 dofs
@@ -0,0 +1,55 @@
+function [A, var, names] = load_poro_bin(fileToRead)
+%LOAD_PORO_BIN(FILETOREAD)
+%  Loads a matrix or vector written by export_system (matrix_export.cpp),
+%  see tools/poro_binary.h for the format.
+%  A:     sparse matrix, or column vector
+%  var:   variable of every row, 1-based index into names
+%  names: variable names
+%
+%  Blocks of the full matrix, as in load_poro.m:
+%    [K, var, names] = load_poro_bin('poro_1_K.bin');
+%    u = strcmp(names, 's_u'); p = strcmp(names, 's_p');
+%    B_grad_u = K(var==find(u), var==find(p));
+
+fid = fopen(fileToRead, 'r');
+if fid < 0
+    error('Cannot read %s', fileToRead);
+end
+
+magic = fread(fid, 8, '*char')';
+if ~strcmp(magic(1:7), 'POROBIN')
+    fclose(fid);
+    error('%s is not a binary export file', fileToRead);
+end
+
+header = fread(fid, 4, 'uint32');
+kind = header(2);
+n_vars = header(4);
+sizes = fread(fid, 3, 'uint64');
+n_rows = sizes(1);
+n_cols = sizes(2);
+nnz = sizes(3);
+
+names = cell(n_vars, 1);
+for v = 1:n_vars
+    name = fread(fid, 32, '*char')';
+    names{v} = name(1:find([name 0] == 0, 1) - 1);
+end
+
+var = fread(fid, n_rows, 'uint32') + 1;
+
+if kind == 0
+    fread(fid, n_cols, 'uint32');
+    row_ptr = fread(fid, n_rows + 1, 'uint64');
+    cols = fread(fid, nnz, 'uint32') + 1;
+    values = fread(fid, nnz, 'double');
+    rows = zeros(nnz, 1);
+    for i = 1:n_rows
+        rows(row_ptr(i) + 1:row_ptr(i + 1)) = i;
+    end
+    A = sparse(rows, cols, values, n_rows, n_cols);
+else
+    A = fread(fid, n_rows, 'double');
+end
+
+fclose(fid);
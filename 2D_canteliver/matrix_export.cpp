@@ -0,0 +1,217 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "dof_map.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "petsc_matrix.h"
+#include "parallel.h"
+
+#include "assemble.h"
+#include "tools/poro_binary.h"
+
+// Binary export of the system matrix and right hand side, replacing the
+// print_matlab text dumps,
+//
+//   -export_matrices data/matrices/poro   file prefix (default off)
+//   -export_step 1                        step to export (default 1)
+//   -export_blocks                        also one file per variable block
+//
+// writes prefix_<step>_K.bin and prefix_<step>_r.bin, and with
+// -export_blocks prefix_<step>_K_<row var>_<col var>.bin for every
+// nonzero block (K_s_u_s_p, K_s_p_x, ...) and prefix_<step>_r_<var>.bin.
+// The format is in tools/poro_binary.h, tools/poro_info.cpp prints the
+// block structure and data/matrices/load_poro_bin.m loads the files.
+//
+// The rows are gathered on processor 0, which writes all files.
+
+
+void write_poro_binary (const std::string& file_name, const uint32_t kind,
+                      const std::vector<std::string>& names,
+                      const std::vector<uint32_t>& row_var, const std::vector<uint32_t>& col_var,
+                      const std::vector<uint64_t>& row_ptr, const std::vector<uint32_t>& cols,
+                      const std::vector<Number>& values)
+{
+  PoroBinaryHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, poro_binary_magic, sizeof(header.magic));
+  header.version = 1;
+  header.kind = kind;
+  header.number_size = sizeof(Number);
+  header.n_vars = names.size();
+  header.n_rows = row_var.size();
+  header.n_cols = (kind == PORO_BINARY_CSR) ? col_var.size() : 1;
+  header.nnz = values.size();
+
+  std::vector<char> name_table(names.size()*PORO_BINARY_NAME, '\0');
+  for (unsigned int v=0; v<names.size(); v++)
+    std::strncpy(&name_table[v*PORO_BINARY_NAME], names[v].c_str(), PORO_BINARY_NAME-1);
+
+  FILE* file = std::fopen(file_name.c_str(), "wb");
+  if (file == NULL)
+  {
+    std::cerr<<"Cannot write "<< file_name <<std::endl;
+    libmesh_error();
+  }
+
+  std::fwrite(&header, sizeof(header), 1, file);
+  std::fwrite(&name_table[0], 1, name_table.size(), file);
+  std::fwrite(&row_var[0], sizeof(uint32_t), row_var.size(), file);
+  if (kind == PORO_BINARY_CSR)
+  {
+    std::fwrite(&col_var[0], sizeof(uint32_t), col_var.size(), file);
+    std::fwrite(&row_ptr[0], sizeof(uint64_t), row_ptr.size(), file);
+    if (!cols.empty())
+      std::fwrite(&cols[0], sizeof(uint32_t), cols.size(), file);
+  }
+  if (!values.empty())
+    std::fwrite(&values[0], sizeof(Number), values.size(), file);
+
+  if (std::fclose(file) != 0)
+  {
+    std::cerr<<"Cannot write "<< file_name <<std::endl;
+    libmesh_error();
+  }
+
+  std::cout<<"Wrote "<< file_name <<std::endl;
+}
+
+
+void export_system (EquationSystems& es,
+                      const std::string& system_name, const unsigned int t_step)
+{
+  const MeshBase& mesh = es.get_mesh();
+
+  LinearImplicitSystem & system =
+    es.get_system<LinearImplicitSystem> (system_name);
+
+  const DofMap & dof_map = system.get_dof_map();
+  const unsigned int n_vars = system.n_vars();
+  const unsigned int n_dofs = system.n_dofs();
+
+  // The local rows, in CSR
+  PetscMatrix<Number>* matrix = dynamic_cast<PetscMatrix<Number>*>(system.matrix);
+  libmesh_assert (matrix != NULL);
+  matrix->close();
+
+  PetscInt first_row, last_row;
+  int ierr = MatGetOwnershipRange(matrix->mat(), &first_row, &last_row);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  std::vector<uint64_t> row_size;
+  std::vector<uint32_t> cols;
+  std::vector<Number> values;
+  for (PetscInt i=first_row; i<last_row; i++)
+  {
+    PetscInt n_row;
+    const PetscInt* row_cols;
+    const PetscScalar* row_values;
+    ierr = MatGetRow(matrix->mat(), i, &n_row, &row_cols, &row_values);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+    row_size.push_back(n_row);
+    for (PetscInt k=0; k<n_row; k++)
+    {
+      cols.push_back(row_cols[k]);
+      values.push_back(row_values[k]);
+    }
+
+    ierr = MatRestoreRow(matrix->mat(), i, &n_row, &row_cols, &row_values);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+
+  // The rows are owned in processor order
+  Parallel::gather(0, row_size);
+  Parallel::gather(0, cols);
+  Parallel::gather(0, values);
+
+  std::vector<Number> rhs;
+  system.rhs->localize_to_one(rhs, 0);
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  std::vector<std::string> names(n_vars);
+  for (unsigned int v=0; v<n_vars; v++)
+    names[v] = system.variable_name(v);
+
+  std::vector<uint32_t> dof_var(n_dofs, 0);
+  std::vector<unsigned int> dof_indices;
+  MeshBase::const_element_iterator       el     = mesh.active_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_elements_end();
+  for ( ; el != end_el; ++el)
+    for (unsigned int v=0; v<n_vars; v++)
+    {
+      dof_map.dof_indices (*el, dof_indices, v);
+      for (unsigned int i=0; i<dof_indices.size(); i++)
+        dof_var[dof_indices[i]] = v;
+    }
+
+  std::vector<uint64_t> row_ptr(n_dofs+1, 0);
+  for (unsigned int i=0; i<n_dofs; i++)
+    row_ptr[i+1] = row_ptr[i] + row_size[i];
+
+  std::stringstream prefix;
+  prefix << es.parameters.get<std::string>("export_prefix") << "_" << t_step;
+
+  const std::vector<uint64_t> no_rows;
+  const std::vector<uint32_t> no_cols;
+
+  write_poro_binary(prefix.str() + "_K.bin", PORO_BINARY_CSR, names, dof_var, dof_var, row_ptr, cols, values);
+  write_poro_binary(prefix.str() + "_r.bin", PORO_BINARY_VECTOR, names, dof_var, no_cols, no_rows, no_cols, rhs);
+
+  if (!es.parameters.get<bool>("export_blocks"))
+    return;
+
+  // Position of every dof within its variable
+  std::vector<uint32_t> block_index(n_dofs);
+  std::vector<uint32_t> block_size(n_vars, 0);
+  for (unsigned int i=0; i<n_dofs; i++)
+    block_index[i] = block_size[dof_var[i]]++;
+
+  for (unsigned int r=0; r<n_vars; r++)
+  {
+    const std::vector<uint32_t> row_var(block_size[r], r);
+
+    std::vector<Number> block_rhs;
+    for (unsigned int i=0; i<n_dofs; i++)
+      if (dof_var[i] == r)
+        block_rhs.push_back(rhs[i]);
+    write_poro_binary(prefix.str() + "_r_" + names[r] + ".bin", PORO_BINARY_VECTOR, names, row_var, no_cols, no_rows, no_cols, block_rhs);
+
+    for (unsigned int c=0; c<n_vars; c++)
+    {
+      std::vector<uint64_t> block_ptr(1, 0);
+      std::vector<uint32_t> block_cols;
+      std::vector<Number> block_values;
+      for (unsigned int i=0; i<n_dofs; i++)
+      {
+        if (dof_var[i] != r)
+          continue;
+        for (uint64_t k=row_ptr[i]; k<row_ptr[i+1]; k++)
+          if (dof_var[cols[k]] == c)
+          {
+            block_cols.push_back(block_index[cols[k]]);
+            block_values.push_back(values[k]);
+          }
+        block_ptr.push_back(block_cols.size());
+      }
+
+      if (block_values.empty())
+        continue;
+
+      const std::vector<uint32_t> col_var(block_size[c], c);
+      write_poro_binary(prefix.str() + "_K_" + names[r] + "_" + names[c] + ".bin", PORO_BINARY_CSR, names, row_var, col_var, block_ptr, block_cols, block_values);
+    }
+  }
+}
@@ -0,0 +1,96 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+
+#include "assemble.h"
+
+// Per step metrics of a run, one CSV row per time step,
+//
+//   -metrics_file data/cant_metrics.csv   (default result_file_name + "_metrics.csv")
+//
+// The file is opened once in append mode, the header is written only if
+// the file is new, so the rows of several runs collect in one file, told
+// apart by their N_eles and n_timesteps columns.  Rows go through a large
+// stream buffer, only processor 0 writes.
+
+struct MetricsLog
+{
+  std::ofstream file;
+  std::vector<char> buffer;
+  unsigned int n_columns;
+};
+
+MetricsLog metrics_log;
+
+
+// Wall clock seconds, for the phase timings of the rows
+Real wall_time ()
+{
+  timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec + 1.e-6*now.tv_usec;
+}
+
+
+void open_metrics (EquationSystems& es, const std::vector<std::string>& columns)
+{
+  metrics_log.n_columns = columns.size();
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  const std::string file_name = command_line_value("-metrics_file",
+    es.parameters.get<std::string>("result_file_name") + "_metrics.csv");
+
+  struct stat file_stat;
+  const bool is_new = (stat(file_name.c_str(), &file_stat) != 0) || (file_stat.st_size == 0);
+
+  metrics_log.buffer.resize(1 << 16);
+  metrics_log.file.rdbuf()->pubsetbuf(&metrics_log.buffer[0], metrics_log.buffer.size());
+  metrics_log.file.open(file_name.c_str(), std::ios::out | std::ios::app);
+  if (!metrics_log.file)
+  {
+    std::cerr<<"Cannot open metrics file "<< file_name <<std::endl;
+    libmesh_error();
+  }
+  metrics_log.file << std::setprecision(10);
+
+  if (is_new)
+  {
+    for (unsigned int c=0; c<columns.size(); c++)
+      metrics_log.file << (c ? "," : "") << columns[c];
+    metrics_log.file << "\n";
+  }
+
+  std::cout<<"metrics_file "<< file_name <<" \n";
+}
+
+
+void write_metrics (const std::vector<Real>& row)
+{
+  libmesh_assert (row.size() == metrics_log.n_columns);
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  for (unsigned int c=0; c<row.size(); c++)
+    metrics_log.file << (c ? "," : "") << row[c];
+  metrics_log.file << "\n";
+}
+
+
+void close_metrics ()
+{
+  if (libMesh::processor_id() != 0)
+    return;
+
+  metrics_log.file.close();
+}
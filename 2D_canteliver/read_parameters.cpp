@@ -42,4 +42,12 @@ if (argc >2){
   std::cout<<"output_file_name "<< es.parameters.get<std::string>("output_file_name") <<" \n";
   std::cout<<"result_file_name "<< es.parameters.get<std::string>("result_file_name") <<" \n";
 
+  //Binary export of the system, see matrix_export.cpp
+  es.parameters.set<std::string> ("export_prefix") = command_line_value("-export_matrices", std::string());
+  es.parameters.set<unsigned int> ("export_step") = command_line_value("-export_step", 1);
+  es.parameters.set<bool> ("export_blocks") = on_command_line("-export_blocks");
+
+  if (!es.parameters.get<std::string>("export_prefix").empty())
+    std::cout<<"export_matrices "<< es.parameters.get<std::string>("export_prefix") <<" step "<< es.parameters.get<unsigned int>("export_step") <<" \n";
+
 }
@@ -0,0 +1,113 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "dof_map.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "dense_matrix.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "elem.h"
+
+#include "assemble.h"
+
+// Pressure jump stabilisation as an operator S on the P0 pressures,
+//
+//   S(e,e) += delta*h_e^2,  S(e,n) -= delta*h_e^2   (h^3 in 3D)
+//
+// for every interior side of element e with neighbour n, delta =
+// dt^beta*PEN_STAB.  The weights were computed twice, in assemble_stiffness
+// for the matrix and in every assemble_rhs for S*p_old.  S is assembled
+// once here ("stabilisation" matrix), assemble_stiffness adds it to the
+// matrix and assemble_rhs adds S*p_old with one product.
+
+
+void assemble_stabilisation (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int p_var = system.variable_number ("s_p");
+  const Real dt = es.parameters.get<Real>("dt");
+  const Real delta_power = es.parameters.get<Real>("beta");
+  const Real delta = pow(dt,delta_power)*PEN_STAB;
+
+  SparseMatrix<Number>& stabilisation = system.get_matrix("stabilisation");
+  stabilisation.zero();
+
+  DenseMatrix<Number> Kstab;
+  std::vector<unsigned int> stab_rows(1);
+  std::vector<unsigned int> stab_cols;
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+
+    stab_rows[0] = elem->dof_number(system.number(), p_var, 0);
+    stab_cols.clear();
+    stab_cols.push_back(stab_rows[0]);
+
+    Real hmax = elem->hmax();
+    #if !THREED
+    const Real factor = delta*hmax*hmax;
+    #endif
+    #if THREED
+    const Real factor = delta*hmax*hmax*hmax;
+    #endif
+
+    Real diagonal = 0.;
+    for (unsigned int s=0; s<elem->n_sides(); s++)
+    {
+      const Elem* neighbor = elem->neighbor(s);
+      if (neighbor == NULL)
+        continue;
+
+      stab_cols.push_back(neighbor->dof_number(system.number(), p_var, 0));
+      diagonal += factor;
+    }
+
+    Kstab.resize(1, stab_cols.size());
+    Kstab(0,0) = diagonal;
+    for (unsigned int k=1; k<stab_cols.size(); k++)
+      Kstab(0,k) = -factor;
+
+    stabilisation.add_matrix(Kstab, stab_rows, stab_cols);
+  }
+
+  stabilisation.close();
+}
+
+
+// rhs += S*p_old
+void add_stabilisation_rhs (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  // Parallel copy of the old solution, S only reads its pressures
+  NumericVector<Number>& old_solution = system.get_vector("stabilisation_old");
+  for (unsigned int i=old_solution.first_local_index(); i<old_solution.last_local_index(); i++)
+    old_solution.set(i, (*system.old_local_solution)(i));
+  old_solution.close();
+
+  system.rhs->add_vector(old_solution, system.get_matrix("stabilisation"));
+}
@@ -0,0 +1,112 @@
+#ifndef PORO_BINARY_H_
+#define PORO_BINARY_H_
+
+// Binary matrix and vector files of export_system (matrix_export.cpp).
+//
+// Every file starts with a PoroBinaryHeader, followed by
+//
+//   char     names[n_vars][PORO_BINARY_NAME]   variable names
+//   uint32_t row_var[n_rows]                    variable of every row
+//
+// and for a matrix (kind PORO_BINARY_CSR)
+//
+//   uint32_t col_var[n_cols]                    variable of every column
+//   uint64_t row_ptr[n_rows+1]                  CSR row starts
+//   uint32_t cols[nnz]                          column of every entry
+//   double   values[nnz]
+//
+// or for a vector (kind PORO_BINARY_VECTOR, n_cols = 1, nnz = n_rows)
+//
+//   double   values[n_rows]
+//
+// in native byte order.  Rows and columns are global dofs, or the dofs of
+// one variable in global order for the block files.  Needs no libMesh.
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define PORO_BINARY_NAME 32
+#define PORO_BINARY_CSR 0
+#define PORO_BINARY_VECTOR 1
+
+struct PoroBinaryHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint32_t number_size;
+  uint32_t n_vars;
+  uint64_t n_rows;
+  uint64_t n_cols;
+  uint64_t nnz;
+};
+
+static const char poro_binary_magic[8] = {'P','O','R','O','B','I','N','\0'};
+
+struct PoroBinary
+{
+  PoroBinaryHeader header;
+  std::vector<std::string> names;
+  std::vector<uint32_t> row_var;
+  std::vector<uint32_t> col_var;
+  std::vector<uint64_t> row_ptr;
+  std::vector<uint32_t> cols;
+  std::vector<double> values;
+};
+
+template <typename T>
+inline bool poro_binary_read_array (FILE* file, std::vector<T>& array, const uint64_t size)
+{
+  array.resize(size);
+  return (size == 0) || (std::fread(&array[0], sizeof(T), size, file) == size);
+}
+
+// Reads file_name into data, false if it is not a valid file
+inline bool read_poro_binary (const std::string& file_name, PoroBinary& data)
+{
+  FILE* file = std::fopen(file_name.c_str(), "rb");
+  if (file == NULL)
+    return false;
+
+  PoroBinaryHeader& header = data.header;
+  bool ok = (std::fread(&header, sizeof(header), 1, file) == 1) &&
+            (std::memcmp(header.magic, poro_binary_magic, sizeof(header.magic)) == 0) &&
+            (header.version == 1) && (header.number_size == sizeof(double));
+
+  if (ok)
+  {
+    std::vector<char> names;
+    ok = poro_binary_read_array(file, names, uint64_t(header.n_vars)*PORO_BINARY_NAME);
+    data.names.clear();
+    for (uint32_t v=0; ok && v<header.n_vars; v++)
+      data.names.push_back(std::string(&names[v*PORO_BINARY_NAME]));
+  }
+
+  ok = ok && poro_binary_read_array(file, data.row_var, header.n_rows);
+
+  if (ok && (header.kind == PORO_BINARY_CSR))
+  {
+    ok = poro_binary_read_array(file, data.col_var, header.n_cols) &&
+         poro_binary_read_array(file, data.row_ptr, header.n_rows+1) &&
+         poro_binary_read_array(file, data.cols, header.nnz) &&
+         poro_binary_read_array(file, data.values, header.nnz) &&
+         (data.row_ptr[header.n_rows] == header.nnz);
+  }
+  else if (ok && (header.kind == PORO_BINARY_VECTOR))
+  {
+    data.col_var.clear();
+    data.row_ptr.clear();
+    data.cols.clear();
+    ok = poro_binary_read_array(file, data.values, header.n_rows);
+  }
+  else
+    ok = false;
+
+  std::fclose(file);
+  return ok;
+}
+
+#endif
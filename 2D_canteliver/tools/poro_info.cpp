@@ -0,0 +1,100 @@
+// Prints the sizes and the block structure of binary matrix and vector
+// files written by export_system, optionally converting them to Matrix
+// Market.
+//
+//   g++ -O2 -o poro_info poro_info.cpp
+//   ./poro_info data/matrices/poro_1_K.bin [-mm K.mtx]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cmath>
+
+#include "poro_binary.h"
+
+
+int main (int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr<<"usage: "<< argv[0] <<" file.bin [-mm file.mtx]"<<std::endl;
+    return 1;
+  }
+
+  PoroBinary data;
+  if (!read_poro_binary(argv[1], data))
+  {
+    std::cerr<<"Cannot read "<< argv[1] <<std::endl;
+    return 1;
+  }
+
+  const PoroBinaryHeader& header = data.header;
+  const unsigned int n_vars = header.n_vars;
+
+  if (header.kind == PORO_BINARY_VECTOR)
+  {
+    std::cout<<"vector "<< header.n_rows <<std::endl;
+
+    std::vector<double> norms(n_vars, 0.);
+    for (uint64_t i=0; i<header.n_rows; i++)
+      norms[data.row_var[i]] += data.values[i]*data.values[i];
+
+    for (unsigned int v=0; v<n_vars; v++)
+      std::cout<< std::setw(8) << data.names[v] <<"  l2 "<< std::sqrt(norms[v]) <<std::endl;
+  }
+  else
+  {
+    std::cout<<"matrix "<< header.n_rows <<" x "<< header.n_cols <<", "<< header.nnz <<" nonzeros"<<std::endl;
+
+    // Nonzeros and largest entry of every variable block
+    std::vector<uint64_t> nnz(n_vars*n_vars, 0);
+    std::vector<double> largest(n_vars*n_vars, 0.);
+    for (uint64_t i=0; i<header.n_rows; i++)
+      for (uint64_t k=data.row_ptr[i]; k<data.row_ptr[i+1]; k++)
+      {
+        const unsigned int block = data.row_var[i]*n_vars + data.col_var[data.cols[k]];
+        nnz[block]++;
+        largest[block] = std::max(largest[block], std::fabs(data.values[k]));
+      }
+
+    std::cout<<"nonzeros (largest entry) of the blocks, rows by columns"<<std::endl;
+    std::cout<< std::setw(8) << "";
+    for (unsigned int c=0; c<n_vars; c++)
+      std::cout<< std::setw(22) << data.names[c];
+    std::cout<<std::endl;
+    for (unsigned int r=0; r<n_vars; r++)
+    {
+      std::cout<< std::setw(8) << data.names[r];
+      for (unsigned int c=0; c<n_vars; c++)
+        if (nnz[r*n_vars+c] > 0)
+          std::cout<< std::setw(10) << nnz[r*n_vars+c] <<" ("<< std::setw(9) << std::setprecision(3) << largest[r*n_vars+c] <<")";
+        else
+          std::cout<< std::setw(22) << "-";
+      std::cout<<std::endl;
+    }
+  }
+
+  if ( (argc > 3) && (std::string(argv[2]) == "-mm") )
+  {
+    std::ofstream mm(argv[3]);
+    mm<< std::setprecision(17);
+    if (header.kind == PORO_BINARY_VECTOR)
+    {
+      mm<<"%%MatrixMarket matrix array real general\n";
+      mm<< header.n_rows <<" 1\n";
+      for (uint64_t i=0; i<header.n_rows; i++)
+        mm<< data.values[i] <<"\n";
+    }
+    else
+    {
+      mm<<"%%MatrixMarket matrix coordinate real general\n";
+      mm<< header.n_rows <<" "<< header.n_cols <<" "<< header.nnz <<"\n";
+      for (uint64_t i=0; i<header.n_rows; i++)
+        for (uint64_t k=data.row_ptr[i]; k<data.row_ptr[i+1]; k++)
+          mm<< i+1 <<" "<< data.cols[k]+1 <<" "<< data.values[k] <<"\n";
+    }
+    std::cout<<"Wrote "<< argv[3] <<std::endl;
+  }
+
+  return 0;
+}
@@ -40,7 +40,10 @@
 #define PC_TYPE PCLU
 #define PETSC_MUMPS 1
 
+//ASCII Tecplot file per step, read by matlab_files/unconfined_main.m
 #define WRITE_TEC 1
+//Binary XDMF field output, one heavy data file and an XML index
+#define WRITE_XDMF 1
 
 
 
@@ -80,6 +83,60 @@ void assemble_error(EquationSystems& es,
 
 void read_options(unsigned int &  n_timesteps, unsigned int &  N_eles, std::string& result_file_name,int& argc, char**& argv) ;
 
+void read_steady_state_options(EquationSystems& es);
+
+void read_time_step_options(EquationSystems& es);
+
+void read_mesh (MeshBase& mesh, const std::string& mesh_file_name);
+
+void read_boundary_conditions (EquationSystems& es);
+
+void build_boundary_sides (EquationSystems& es,
+                      const std::string& system_name);
+
+void assemble_boundary_conditions (EquationSystems& es, const std::string& system_name,
+                      std::vector<int>& rows, std::vector<Real>& rows_values,
+                      std::vector<int>& pressure_rows, std::vector<Real>& pressure_rows_values);
+
+void read_laplace_options(EquationSystems& es, std::vector<Real>& times);
+
+void laplace_solve (EquationSystems& es, const std::string& system_name,
+                      const std::vector<Real>& times, std::vector<NumericVector<Number>*>& solutions);
+
+Real steady_state_increment (EquationSystems& es,
+                      const std::string& system_name);
+
+Real max_pressure (EquationSystems& es,
+                      const std::string& system_name);
+
+Real estimate_time_error (EquationSystems& es,
+                      const std::string& system_name,
+                      const Real dt, const Real dt_old);
+
+void write_run_metadata (EquationSystems& es, const std::string& result_file_name,
+                      const std::string& stop_reason, const unsigned int t_step, const Real time,
+                      const Real increment, const Real p_max);
+
+void open_output (EquationSystems& es, const std::string& file_name, const std::string& tec_prefix);
+
+void write_output (EquationSystems& es, const unsigned int step, const Real time);
+
+void close_output ();
+
+void setup_probes (EquationSystems& es, const std::string& file_name);
+
+void write_probes (EquationSystems& es, const Real time);
+
+void close_probes ();
+
+void write_checkpoint (EquationSystems& es, const std::string& file_name,
+                      const unsigned int t_step, const Real time, const Real dt,
+                      const bool steady, const Real increment, const Real p_max);
+
+void read_checkpoint (EquationSystems& es, const std::string& file_name,
+                      unsigned int& t_step, Real& time, Real& dt,
+                      bool& steady, Real& increment, Real& p_max);
+
 
 void test(int a);
 
@@ -637,57 +637,15 @@ Real fluid_fac=(1.0/KPERM);
   #endif 
   //endif PRES_STAB
 
-#if PRES_STAB 
-//#include "assemble_stokes_bcs_p1p1p0_anal_sine.cpp"
-
-  #if NITSCHE
-  #if THREED
-  //#include "nitsche_disp_bcs.cpp"
-  //#include "penalty_bcs.cpp"
-
-  //Darcy fluid only
-  //#include "nitsche_fluid_cylinder_bcs.cpp"
-
-  #include "classic_fluid_cylinder_bcs.cpp"
-
-  //Classic dirichlet for dispalcement
-  #include "classic_disp_cylinder_bcs.cpp"
-
-
-
-  #endif
-
-    #if !THREED
-
-  //Darcy fluid only
-
-  //#include "nitsche_fluid_square_bcs.cpp"
-  //#include "classic_square_fluid_bcs.cpp"
-
-
-  //#include "nitsche_disp_square_bcs.cpp"
- // #include "classic_square_disp_bcs.cpp"
-  #endif
-
-  #endif
-
-#endif
-
-
-
-#if !PRES_STAB 
-#include "unconfined_cylinder_bcs.cpp"
-#endif
-
-//#include "cube_squash_bcs.cpp"
-
-
-
+//The boundary conditions are assembled over the boundary sides only,
+//after the element loop (boundary_conditions.cpp)
 
   system.matrix->add_matrix (Ke, dof_indices);
   system.rhs->add_vector    (Fe, dof_indices);
 
 } // end of element loop
+
+    assemble_boundary_conditions(es, system_name, rows, rows_values, pressure_rows, pressure_rows_values);
   
     system.matrix->close();
     system.rhs->close();
@@ -0,0 +1,487 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "boundary_info.h"
+#include "equation_systems.h"
+#include "fe.h"
+#include "quadrature_gauss.h"
+#include "dof_map.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "dense_matrix.h"
+#include "dense_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "elem.h"
+#include "getpot.h"
+
+#include "assemble.h"
+
+// Boundary conditions chosen at run time instead of by the bcs fragments
+// included into the element loop of assemble_stokes.
+//
+// -bc_file <file> reads the conditions from a GetPot input file, see
+// bcs.in; without it the conditions of the compiled configuration are
+// used.  Every condition acts on a region of the boundary, either the
+// sides with a boundary id of the mesh or the part of the boundary in a
+// box (x_min ... z_max, r_min r_max for the radius around the z axis):
+//   dirichlet     variables = value at the nodes of the region
+//   penalty       (penalty/h (u-value), v) on the variables
+//   nitsche_flux  Darcy flux with normal component value, as in
+//                 nitsche_fluid_cylinder_bcs.cpp
+//
+// The boundary sides and their face data (JxW, normals, quadrature points
+// and shape functions) are found once in build_boundary_sides, the mesh
+// does not move.  The Dirichlet rows are found at the same time, so the
+// interior elements do no boundary work at all.
+
+struct BoundaryCondition
+{
+  std::string name;
+  std::string type;
+  std::vector<std::string> variables;
+  Real value;
+  Real penalty;
+
+  // -1: the region is the box
+  int boundary_id;
+  Real x_min, x_max, y_min, y_max, z_min, z_max, r_min, r_max;
+
+  BoundaryCondition (const std::string& bc_name, const std::string& bc_type, const Real bc_value) :
+    name(bc_name), type(bc_type), value(bc_value), penalty(PEN_BC), boundary_id(-1),
+    x_min(-1.e30), x_max(1.e30), y_min(-1.e30), y_max(1.e30),
+    z_min(-1.e30), z_max(1.e30), r_min(-1.), r_max(1.e30) {}
+
+  bool contains (const Point& p) const
+  {
+    const Real r = sqrt(p(0)*p(0) + p(1)*p(1));
+    return (p(0) > x_min) && (p(0) < x_max) && (p(1) > y_min) && (p(1) < y_max) &&
+      (p(2) > z_min) && (p(2) < z_max) && (r > r_min) && (r < r_max);
+  }
+};
+
+
+// Face data of a boundary side, phi_f for the displacement/flux variables
+// and phi_p for the pressure
+struct BoundarySide
+{
+  const Elem* elem;
+  unsigned int side;
+  Real h_elem;
+  std::vector<Real> JxW;
+  std::vector<Point> q_point;
+  std::vector<Point> normals;
+  std::vector<std::vector<Real> > phi_f;
+  std::vector<std::vector<Real> > phi_p;
+};
+
+
+std::vector<BoundaryCondition> boundary_conditions;
+
+// Boundary sides of the local elements used by a weak condition, and the
+// sides every weak condition acts on
+std::vector<BoundarySide> boundary_sides;
+std::vector<std::vector<unsigned int> > weak_bc_sides;
+
+// Rows and values of the Dirichlet conditions
+std::vector<int> dirichlet_rows;
+std::vector<Real> dirichlet_values;
+std::vector<int> dirichlet_pressure_rows;
+std::vector<Real> dirichlet_pressure_values;
+
+
+// The conditions of the bcs fragments that assemble_stokes included
+void default_boundary_conditions ()
+{
+  boundary_conditions.clear();
+
+#if PRES_STAB
+  Real top_displacement = -0.05;
+#endif
+#if !PRES_STAB
+  Real top_displacement = -0.4;
+#endif
+
+  //No outflow at top and bottom (classic_fluid_cylinder_bcs.cpp)
+  BoundaryCondition bottom_flux("bottom_flux", "dirichlet", 0.);
+  bottom_flux.variables.push_back("z");
+  bottom_flux.z_max = 0.001;
+  boundary_conditions.push_back(bottom_flux);
+
+  BoundaryCondition top_flux("top_flux", "dirichlet", 0.);
+  top_flux.variables.push_back("z");
+  top_flux.z_min = 0.999;
+  boundary_conditions.push_back(top_flux);
+
+  //Constrain bottom in z direction, let the rest slide (classic_disp_cylinder_bcs.cpp)
+  BoundaryCondition bottom("bottom", "dirichlet", 0.);
+  bottom.variables.push_back("s_w");
+  bottom.z_max = 0.001;
+  boundary_conditions.push_back(bottom);
+
+  //Fix one node
+  BoundaryCondition fix_point("fix_point", "dirichlet", 0.);
+  fix_point.variables.push_back("s_u");
+  fix_point.variables.push_back("s_v");
+  fix_point.variables.push_back("s_w");
+  fix_point.z_max = 0.001;
+  fix_point.x_max = -0.99;
+  fix_point.y_min = -0.1;
+  fix_point.y_max = 0.1;
+  boundary_conditions.push_back(fix_point);
+
+  //Control another node
+  BoundaryCondition control_point("control_point", "dirichlet", 0.);
+  control_point.variables.push_back("s_v");
+  control_point.variables.push_back("s_w");
+  control_point.z_max = 0.001;
+  control_point.x_min = 0.99;
+  control_point.y_min = -0.1;
+  control_point.y_max = 0.1;
+  boundary_conditions.push_back(control_point);
+
+  //Compress the top
+  BoundaryCondition top("top", "dirichlet", top_displacement);
+  top.variables.push_back("s_w");
+  top.z_min = 0.999;
+  boundary_conditions.push_back(top);
+}
+
+
+void read_boundary_conditions (EquationSystems& es)
+{
+  const std::string bc_file = command_line_value("-bc_file", std::string(""));
+  es.parameters.set<std::string> ("bc_file") = bc_file;
+
+  if (bc_file == "")
+  {
+    default_boundary_conditions();
+    std::cout<<"Boundary conditions of the compiled configuration \n";
+  }
+  else
+  {
+    GetPot input(bc_file.c_str());
+    boundary_conditions.clear();
+
+    const unsigned int n_bcs = input.vector_variable_size("conditions");
+    if (n_bcs == 0)
+    {
+      std::cerr<<"No conditions in "<< bc_file <<std::endl;
+      libmesh_error();
+    }
+
+    for (unsigned int b=0; b<n_bcs; b++)
+    {
+      const std::string name = input("conditions", "", b);
+      const std::string section = name + "/";
+
+      BoundaryCondition bc(name, input((section+"type").c_str(), ""), input((section+"value").c_str(), 0.));
+      if ( (bc.type != "dirichlet") && (bc.type != "penalty") && (bc.type != "nitsche_flux") )
+      {
+        std::cerr<<"Unknown boundary condition type "<< bc.type <<" of "<< name <<std::endl;
+        libmesh_error();
+      }
+
+      const std::string variables_name = section + "variables";
+      for (unsigned int v=0; v<input.vector_variable_size(variables_name.c_str()); v++)
+        bc.variables.push_back(input(variables_name.c_str(), "", v));
+
+      bc.penalty = input((section+"penalty").c_str(), bc.penalty);
+      bc.boundary_id = input((section+"boundary_id").c_str(), bc.boundary_id);
+      bc.x_min = input((section+"x_min").c_str(), bc.x_min);
+      bc.x_max = input((section+"x_max").c_str(), bc.x_max);
+      bc.y_min = input((section+"y_min").c_str(), bc.y_min);
+      bc.y_max = input((section+"y_max").c_str(), bc.y_max);
+      bc.z_min = input((section+"z_min").c_str(), bc.z_min);
+      bc.z_max = input((section+"z_max").c_str(), bc.z_max);
+      bc.r_min = input((section+"r_min").c_str(), bc.r_min);
+      bc.r_max = input((section+"r_max").c_str(), bc.r_max);
+
+      boundary_conditions.push_back(bc);
+    }
+
+    std::cout<<"Boundary conditions from "<< bc_file <<" \n";
+  }
+
+  for (unsigned int b=0; b<boundary_conditions.size(); b++)
+  {
+    std::cout<<"  "<< boundary_conditions[b].name <<": "<< boundary_conditions[b].type;
+    for (unsigned int v=0; v<boundary_conditions[b].variables.size(); v++)
+      std::cout<<" "<< boundary_conditions[b].variables[v];
+    std::cout<<" = "<< boundary_conditions[b].value <<" \n";
+  }
+}
+
+
+// Boundary sides, face data and Dirichlet rows, once after
+// equation_systems.init()
+void build_boundary_sides (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+  const unsigned int dim = mesh.mesh_dimension();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int u_var = system.variable_number ("s_u");
+  const unsigned int p_var = system.variable_number ("s_p");
+  const unsigned int x_var = system.variable_number ("x");
+
+  // Displacement and flux share the face shape functions
+  FEType fe_vel_type = system.variable_type(x_var);
+  FEType fe_pres_type = system.variable_type(p_var);
+  libmesh_assert (system.variable_type(u_var) == fe_vel_type);
+
+  AutoPtr<FEBase> fe_face_f (FEBase::build(dim, fe_vel_type));
+  AutoPtr<QBase> qface_f(fe_vel_type.default_quadrature_rule(dim-1));
+  fe_face_f->attach_quadrature_rule (qface_f.get());
+
+  AutoPtr<FEBase> fe_face_p (FEBase::build(dim, fe_pres_type));
+  fe_face_p->attach_quadrature_rule (qface_f.get());
+
+  const std::vector<std::vector<Real> >& phi_face_f = fe_face_f->get_phi();
+  const std::vector<Real>& JxW_face_f = fe_face_f->get_JxW();
+  const std::vector<Point>& qface_point_f = fe_face_f->get_xyz();
+  const std::vector<Point>& face_normals_f = fe_face_f->get_normals();
+  const std::vector<std::vector<Real> >& phi_face_p = fe_face_p->get_phi();
+
+  boundary_sides.clear();
+  weak_bc_sides.assign(boundary_conditions.size(), std::vector<unsigned int>());
+
+  // Later conditions override earlier ones on the same dof
+  std::map<int, Real> rows;
+  std::map<int, Real> pressure_rows;
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    const Elem* elem = *el;
+
+    for (unsigned int s=0; s<elem->n_sides(); s++)
+    {
+      if (elem->neighbor(s) != NULL)
+        continue;
+
+      AutoPtr<Elem> side (elem->build_side(s));
+      const short int side_id = mesh.boundary_info->boundary_id(elem, s);
+      bool face_data = false;
+
+      for (unsigned int b=0; b<boundary_conditions.size(); b++)
+      {
+        const BoundaryCondition& bc = boundary_conditions[b];
+        if ( (bc.boundary_id >= 0) && (bc.boundary_id != side_id) )
+          continue;
+
+        if (bc.type == "dirichlet")
+        {
+          for (unsigned int ns=0; ns<side->n_nodes(); ns++)
+          {
+            const Node* node = side->get_node(ns);
+            if ( (bc.boundary_id < 0) && !bc.contains(*node) )
+              continue;
+
+            for (unsigned int v=0; v<bc.variables.size(); v++)
+            {
+              const unsigned int var = system.variable_number(bc.variables[v]);
+
+              // P0 pressure of the element
+              if (var == p_var)
+              {
+                const unsigned int source_dof = elem->dof_number(system.number(), p_var, 0);
+                if (source_dof != DofObject::invalid_id)
+                  pressure_rows[source_dof] = bc.value;
+                continue;
+              }
+
+              const unsigned int source_dof = node->dof_number(system.number(), var, 0);
+              if (source_dof != DofObject::invalid_id)
+                rows[source_dof] = bc.value;
+            }
+          }
+          continue;
+        }
+
+        // Weak conditions need the face data
+        if (!face_data)
+        {
+          fe_face_f->reinit(elem,s);
+          fe_face_p->reinit(elem,s);
+
+          BoundarySide bs;
+          bs.elem = elem;
+          bs.side = s;
+          // h elemet dimension to compute the interior penalty penalty parameter
+          const unsigned int elem_b_order = static_cast<unsigned int> (fe_face_f->get_order());
+          bs.h_elem = elem->volume()/side->volume() * 1./pow(elem_b_order, 2.);
+          bs.JxW = JxW_face_f;
+          bs.q_point = qface_point_f;
+          bs.normals = face_normals_f;
+          bs.phi_f = phi_face_f;
+          bs.phi_p = phi_face_p;
+          boundary_sides.push_back(bs);
+          face_data = true;
+        }
+
+        const BoundarySide& bs = boundary_sides.back();
+        bool in_region = (bc.boundary_id >= 0);
+        for (unsigned int qp=0; qp<bs.q_point.size(); qp++)
+          in_region = in_region || bc.contains(bs.q_point[qp]);
+
+        if (in_region)
+          weak_bc_sides[b].push_back(boundary_sides.size()-1);
+      }
+    }
+  }
+
+  dirichlet_rows.clear();
+  dirichlet_values.clear();
+  for (std::map<int, Real>::const_iterator it = rows.begin(); it != rows.end(); ++it)
+  {
+    dirichlet_rows.push_back(it->first);
+    dirichlet_values.push_back(it->second);
+  }
+
+  dirichlet_pressure_rows.clear();
+  dirichlet_pressure_values.clear();
+  for (std::map<int, Real>::const_iterator it = pressure_rows.begin(); it != pressure_rows.end(); ++it)
+  {
+    dirichlet_pressure_rows.push_back(it->first);
+    dirichlet_pressure_values.push_back(it->second);
+  }
+
+  std::cout<<"Boundary sides with weak conditions "<< boundary_sides.size() <<", Dirichlet rows "<< dirichlet_rows.size() <<", pressure rows "<< dirichlet_pressure_rows.size() <<std::endl;
+}
+
+
+// Adds the weak conditions to the matrix and rhs and appends the
+// Dirichlet rows, called by assemble_stokes before the matrix is closed.
+void assemble_boundary_conditions (EquationSystems& es, const std::string& system_name,
+                      std::vector<int>& rows, std::vector<Real>& rows_values,
+                      std::vector<int>& pressure_rows, std::vector<Real>& pressure_rows_values)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+  const DofMap & dof_map = system.get_dof_map();
+
+  const unsigned int p_var = system.variable_number ("s_p");
+  std::vector<unsigned int> flux_vars;
+  flux_vars.push_back(system.variable_number ("x"));
+  flux_vars.push_back(system.variable_number ("y"));
+  #if THREED
+  flux_vars.push_back(system.variable_number ("z"));
+  #endif
+
+  DenseMatrix<Number> Kb;
+  DenseVector<Number> Fb;
+  std::vector<unsigned int> dof_indices_a;
+  std::vector<unsigned int> dof_indices_b;
+
+  for (unsigned int b=0; b<boundary_conditions.size(); b++)
+  {
+    const BoundaryCondition& bc = boundary_conditions[b];
+
+    for (unsigned int k=0; k<weak_bc_sides[b].size(); k++)
+    {
+      const BoundarySide& bs = boundary_sides[weak_bc_sides[b][k]];
+      const Real penalty = bc.penalty;
+      const Real h_elem = bs.h_elem;
+
+      if (bc.type == "penalty")
+      {
+        // (penalty/h_elem*(u-value),v)_{Gamma}
+        for (unsigned int v=0; v<bc.variables.size(); v++)
+        {
+          const unsigned int var = system.variable_number(bc.variables[v]);
+          dof_map.dof_indices (bs.elem, dof_indices_a, var);
+          Kb.resize (dof_indices_a.size(), dof_indices_a.size());
+          Fb.resize (dof_indices_a.size());
+
+          // The pressure has its own basis
+          const std::vector<std::vector<Real> >& phi = (var == p_var) ? bs.phi_p : bs.phi_f;
+
+          for (unsigned int qp=0; qp<bs.JxW.size(); qp++)
+          {
+            if ( (bc.boundary_id < 0) && !bc.contains(bs.q_point[qp]) )
+              continue;
+            for (unsigned int i=0; i<dof_indices_a.size(); i++)
+            {
+              for (unsigned int j=0; j<dof_indices_a.size(); j++)
+                Kb(i,j) += penalty/h_elem*bs.JxW[qp]*phi[i][qp]*phi[j][qp];
+              Fb(i) += bc.value*penalty/h_elem*bs.JxW[qp]*phi[i][qp];
+            }
+          }
+
+          system.matrix->add_matrix (Kb, dof_indices_a);
+          system.rhs->add_vector (Fb, dof_indices_a);
+        }
+      }
+
+      if (bc.type == "nitsche_flux")
+      {
+        dof_map.dof_indices (bs.elem, dof_indices_b, p_var);
+
+        for (unsigned int d=0; d<flux_vars.size(); d++)
+        {
+          dof_map.dof_indices (bs.elem, dof_indices_a, flux_vars[d]);
+
+          // (p,v.n)_{Gamma} term
+          Kb.resize (dof_indices_b.size(), dof_indices_a.size());
+          Fb.resize (dof_indices_b.size());
+          for (unsigned int qp=0; qp<bs.JxW.size(); qp++)
+          {
+            if ( (bc.boundary_id < 0) && !bc.contains(bs.q_point[qp]) )
+              continue;
+            for (unsigned int i=0; i<dof_indices_b.size(); i++)
+            {
+              for (unsigned int j=0; j<dof_indices_a.size(); j++)
+                Kb(i,j) += bs.JxW[qp]*bs.phi_p[i][qp]*bs.phi_f[j][qp]*bs.normals[qp](d);
+              // (u0.n,q)_D, once for the pressure rows
+              if (d == 0)
+                Fb(i) += bc.value*bs.JxW[qp]*bs.phi_p[i][qp];
+            }
+          }
+          system.matrix->add_matrix (Kb, dof_indices_b, dof_indices_a);
+          system.rhs->add_vector (Fb, dof_indices_b);
+
+          // (penalty/h_elem*u.n,v.n)_{Gamma} stability term and (u0.n,penalty/h_elem*v.n)_D
+          Kb.resize (dof_indices_a.size(), dof_indices_a.size());
+          Fb.resize (dof_indices_a.size());
+          for (unsigned int qp=0; qp<bs.JxW.size(); qp++)
+          {
+            if ( (bc.boundary_id < 0) && !bc.contains(bs.q_point[qp]) )
+              continue;
+            const Real n_d = bs.normals[qp](d);
+            for (unsigned int i=0; i<dof_indices_a.size(); i++)
+            {
+              for (unsigned int j=0; j<dof_indices_a.size(); j++)
+                Kb(i,j) += penalty/h_elem*bs.JxW[qp]*bs.phi_f[i][qp]*n_d*bs.phi_f[j][qp]*n_d;
+              Fb(i) += bc.value*penalty/h_elem*bs.JxW[qp]*bs.phi_f[i][qp]*n_d;
+            }
+          }
+          system.matrix->add_matrix (Kb, dof_indices_a);
+          system.rhs->add_vector (Fb, dof_indices_a);
+        }
+      }
+    }
+  }
+
+  rows.insert(rows.end(), dirichlet_rows.begin(), dirichlet_rows.end());
+  rows_values.insert(rows_values.end(), dirichlet_values.begin(), dirichlet_values.end());
+  pressure_rows.insert(pressure_rows.end(), dirichlet_pressure_rows.begin(), dirichlet_pressure_rows.end());
+  pressure_rows_values.insert(pressure_rows_values.end(), dirichlet_pressure_values.begin(), dirichlet_pressure_values.end());
+}
@@ -0,0 +1,195 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "dof_map.h"
+
+#include "assemble.h"
+
+
+// Checkpoints of the time loop, result_file_name + ".chk",
+//
+//   -checkpoint_every 10     write a checkpoint every 10 steps (default off)
+//   -restart data/run.chk    continue the time loop from a checkpoint
+//
+// The file is a fixed header followed by the solution of
+// Last_non_linear_soln as raw Numbers in global dof order, 8 byte aligned
+// so a restart maps it and copies its local range.  The old solution is
+// not stored: every step starts by copying the current solution into it,
+// so a restart sets it from the solution.  The values are written
+// unchanged, a restarted run with fixed steps repeats the steps of the
+// original bit for bit.  With -dt_tol the first step after a restart has
+// no u^{n-1} and is accepted without an error estimate.
+//
+// Processor 0 writes file_name + ".tmp" and renames it over the last
+// checkpoint, a crash while writing leaves the previous one intact.
+
+struct CheckpointHeader
+{
+  char magic[8];
+  unsigned int version;
+  unsigned int number_size;
+
+  // Checked against the mesh and system of the restarted run
+  unsigned int n_dofs;
+  unsigned int n_elem;
+  unsigned int n_nodes;
+
+  unsigned int t_step;
+  unsigned int steady;
+  unsigned int steady_step;
+
+  Real time;
+  Real dt;
+  Real increment;
+  Real p_max;
+  Real steady_time;
+};
+
+static const char checkpoint_magic[8] = {'P','O','R','O','C','H','K','\0'};
+
+
+void write_checkpoint (EquationSystems& es, const std::string& file_name,
+                      const unsigned int t_step, const Real time, const Real dt,
+                      const bool steady, const Real increment, const Real p_max)
+{
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  // Collective
+  std::vector<Number> solution;
+  system.solution->localize(solution);
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  CheckpointHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+  header.version = 2;
+  header.number_size = sizeof(Number);
+  header.n_dofs = system.n_dofs();
+  header.n_elem = es.get_mesh().n_elem();
+  header.n_nodes = es.get_mesh().n_nodes();
+  header.t_step = t_step;
+  header.steady = steady;
+  header.time = time;
+  header.dt = dt;
+  header.increment = increment;
+  header.p_max = p_max;
+  if (steady)
+  {
+    header.steady_step = es.parameters.get<unsigned int>("steady_step");
+    header.steady_time = es.parameters.get<Real>("steady_time");
+  }
+
+  const std::string tmp_name = file_name + ".tmp";
+  FILE* file = std::fopen(tmp_name.c_str(), "wb");
+  if (file == NULL)
+  {
+    std::cerr<<"Cannot write checkpoint "<< tmp_name <<std::endl;
+    libmesh_error();
+  }
+
+  bool ok = (std::fwrite(&header, sizeof(header), 1, file) == 1);
+  ok = ok && (std::fwrite(&solution[0], sizeof(Number), solution.size(), file) == solution.size());
+  ok = ok && (std::fflush(file) == 0) && (fsync(fileno(file)) == 0);
+  ok = (std::fclose(file) == 0) && ok;
+
+  if (!ok || (std::rename(tmp_name.c_str(), file_name.c_str()) != 0))
+  {
+    std::cerr<<"Cannot write checkpoint "<< file_name <<std::endl;
+    libmesh_error();
+  }
+
+  std::cout<<"Wrote checkpoint "<< file_name <<" (step "<< t_step <<", time "<< time <<")"<<std::endl;
+}
+
+
+// Copies the local range of "values" into "vector"
+void restore_vector (NumericVector<Number>& vector, const Number* values)
+{
+  for (unsigned int i=vector.first_local_index(); i<vector.last_local_index(); i++)
+    vector.set(i, values[i]);
+  vector.close();
+}
+
+
+void read_checkpoint (EquationSystems& es, const std::string& file_name,
+                      unsigned int& t_step, Real& time, Real& dt,
+                      bool& steady, Real& increment, Real& p_max)
+{
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int n_dofs = system.n_dofs();
+  const size_t size = sizeof(CheckpointHeader) + n_dofs*sizeof(Number);
+
+  // Every processor maps the file and reads its own range
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if ( (fd < 0) || (fstat(fd, &file_stat) != 0) || (static_cast<size_t>(file_stat.st_size) < sizeof(CheckpointHeader)) )
+  {
+    std::cerr<<"Cannot read checkpoint "<< file_name <<std::endl;
+    libmesh_error();
+  }
+
+  void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    std::cerr<<"Cannot map checkpoint "<< file_name <<std::endl;
+    libmesh_error();
+  }
+
+  const CheckpointHeader& header = *static_cast<const CheckpointHeader*>(data);
+  if ( (std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0) ||
+       (header.version != 2) || (header.number_size != sizeof(Number)) ||
+       (static_cast<size_t>(file_stat.st_size) != size) )
+  {
+    std::cerr<<"Not a checkpoint of this build: "<< file_name <<std::endl;
+    libmesh_error();
+  }
+  if ( (header.n_dofs != n_dofs) || (header.n_elem != es.get_mesh().n_elem()) ||
+       (header.n_nodes != es.get_mesh().n_nodes()) )
+  {
+    std::cerr<<"Checkpoint "<< file_name <<" is for another mesh ("<< header.n_elem <<" elements, "<< header.n_dofs <<" dofs)"<<std::endl;
+    libmesh_error();
+  }
+
+  const Number* solution = reinterpret_cast<const Number*>(static_cast<const char*>(data) + sizeof(CheckpointHeader));
+
+  restore_vector(*system.solution, solution);
+  system.update();
+  *system.old_local_solution = *system.current_local_solution;
+
+  t_step = header.t_step;
+  time = header.time;
+  dt = header.dt;
+  steady = header.steady;
+  increment = header.increment;
+  p_max = header.p_max;
+  if (steady)
+  {
+    es.parameters.set<unsigned int>("steady_step") = header.steady_step;
+    es.parameters.set<Real>("steady_time") = header.steady_time;
+  }
+
+  munmap(data, file_stat.st_size);
+
+  std::cout<<"Restarting from "<< file_name <<" at step "<< t_step <<", time "<< time <<", dt "<< dt <<std::endl;
+}
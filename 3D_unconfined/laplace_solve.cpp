@@ -0,0 +1,435 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <complex>
+#include <sstream>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "sparse_matrix.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "petsc_matrix.h"
+#include "petsc_vector.h"
+#include "petsc_macro.h"
+#include "parallel.h"
+
+#include "assemble.h"
+
+// Laplace domain solve for a load that is switched on at t=0 and then
+// held fixed.
+//
+// The backward Euler system from assemble_stokes is affine in dt,
+//   K(dt) x^{n+1} = F(dt),  K(dt) = C0 + dt C1,  F(dt) = R0 + dt R1,
+// where C0 holds the algebraic rows (elasticity, Darcy, BCs) and div u
+// in the mass rows, C1 the div z and stabilisation terms of the mass
+// rows.  With zero history the Laplace transform of the DAE is
+//   (s C0 + C1) X(s) = R0 + R1/s
+// (the algebraic rows multiplied by s), so every contour point is one
+// complex solve with the two real matrices assembled at dt=0 and dt=1.
+//
+// x(t) is recovered with the fixed Talbot contour of Abate and Valko,
+//   x(t) = r/M [ 1/2 e^{rt} X(r) + sum_k Re( e^{t s_k} X(s_k) (1+i sigma_k) ) ]
+//   s_k = r theta_k (cot theta_k + i), theta_k = k pi/M, r = 2M/(5t).
+// The complex systems are solved in real equivalent form with the
+// real and imaginary part of every dof interleaved,
+//   [ Re(s) C0 + C1   -Im(s) C0     ] [Xr]   [R0 + Re(1/s) R1]
+//   [ Im(s) C0         Re(s) C0 + C1] [Xi] = [     Im(1/s) R1].
+//
+// The contour points are independent.  The processors are split into
+// groups, every group solves its share of the points (k = group mod
+// n_groups) on its own communicator, and the weighted sums of the groups
+// are added over all processors.  C0, C1, R0 and R1 are assembled with
+// the libMesh partitioning and then copied to every processor, so each
+// group builds its real equivalent matrices over its own rows.
+
+
+
+
+// -laplace_times t1,t2,...  output times of the Laplace solve, "steps"
+//                           gives the output times of the time stepping
+// -talbot_points M          contour points per output time
+// -laplace_groups G         processor groups solving contour points
+//                           concurrently (default one per processor)
+void read_laplace_options(EquationSystems& es, std::vector<Real>& times)
+{
+  const std::string laplace_times = command_line_value("-laplace_times", std::string(""));
+  es.parameters.set<unsigned int> ("talbot_points") = command_line_value("-talbot_points", 16);
+  es.parameters.set<unsigned int> ("laplace_groups") =
+    std::max(command_line_value("-laplace_groups", static_cast<int>(libMesh::n_processors())), 1);
+
+  times.clear();
+  if (laplace_times == "steps")
+  {
+    const Real dt = es.parameters.get<Real>("dt");
+    const Real end_time = es.parameters.get<Real>("end_time");
+    for (unsigned int i=1; i*dt <= end_time*(1.+1.e-10); i++)
+      times.push_back(i*dt);
+  }
+  else
+  {
+    std::stringstream time_list(laplace_times);
+    std::string entry;
+    while (std::getline(time_list, entry, ','))
+      if (!entry.empty())
+        times.push_back(atof(entry.c_str()));
+  }
+
+  if (!times.empty())
+    std::cout<<"Laplace solve at "<< times.size() <<" times with "<< es.parameters.get<unsigned int>("talbot_points") <<" Talbot points \n";
+}
+
+
+// C0 and C1 (on the sparsity of C0), R0 and R1, all rows
+struct LaplaceOperator
+{
+  std::vector<unsigned int> row_ptr;
+  std::vector<unsigned int> cols;
+  std::vector<Real> c0, c1;
+  std::vector<Real> r0, r1;
+};
+
+
+// Copies the local rows of C0, C1, R0 and R1 to every processor, the
+// rows are owned in processor order
+void gather_laplace_operator (Mat C0, Mat C1, Vec R0, Vec R1, LaplaceOperator& op)
+{
+  PetscInt first, last;
+  int ierr = MatGetOwnershipRange(C0, &first, &last);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  std::vector<unsigned int> row_size;
+  op.cols.clear();
+  op.c0.clear();
+  op.c1.clear();
+  for (PetscInt i=first; i<last; i++)
+  {
+    PetscInt ncols, ncols1;
+    const PetscInt *row_cols, *row_cols1;
+    const PetscScalar *row_vals, *row_vals1;
+
+    ierr = MatGetRow(C0, i, &ncols, &row_cols, &row_vals);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = MatGetRow(C1, i, &ncols1, &row_cols1, &row_vals1);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+    // C1 = K(1) - C0 was formed with SAME_NONZERO_PATTERN
+    libmesh_assert (ncols1 == ncols);
+    row_size.push_back(ncols);
+    for (PetscInt j=0; j<ncols; j++)
+    {
+      op.cols.push_back(row_cols[j]);
+      op.c0.push_back(row_vals[j]);
+      op.c1.push_back(row_vals1[j]);
+    }
+
+    ierr = MatRestoreRow(C1, i, &ncols1, &row_cols1, &row_vals1);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = MatRestoreRow(C0, i, &ncols, &row_cols, &row_vals);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+
+  op.r0.resize(last-first);
+  op.r1.resize(last-first);
+  PetscScalar *r0_array, *r1_array;
+  ierr = VecGetArray(R0, &r0_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecGetArray(R1, &r1_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  for (PetscInt l=0; l<last-first; l++)
+  {
+    op.r0[l] = r0_array[l];
+    op.r1[l] = r1_array[l];
+  }
+  ierr = VecRestoreArray(R1, &r1_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecRestoreArray(R0, &r0_array);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  Parallel::allgather(row_size);
+  Parallel::allgather(op.cols);
+  Parallel::allgather(op.c0);
+  Parallel::allgather(op.c1);
+  Parallel::allgather(op.r0);
+  Parallel::allgather(op.r1);
+
+  op.row_ptr.assign(row_size.size()+1, 0);
+  for (unsigned int i=0; i<row_size.size(); i++)
+    op.row_ptr[i+1] = op.row_ptr[i] + row_size[i];
+}
+
+
+// Fill A = real equivalent of s C0 + C1 over rows first..last of the
+// group, rows 2i and 2i+1 for dof i.
+void fill_laplace_matrix (const LaplaceOperator& op, Mat A, const PetscInt first, const PetscInt last,
+                      const std::complex<Real> s)
+{
+  const PetscScalar sr = std::real(s);
+  const PetscScalar si = std::imag(s);
+
+  std::vector<PetscInt> cols;
+  std::vector<PetscScalar> real_row, imag_row;
+  int ierr;
+  for (PetscInt i=first; i<last; i++)
+  {
+    const unsigned int ncols = op.row_ptr[i+1] - op.row_ptr[i];
+    cols.resize(2*ncols);
+    real_row.resize(2*ncols);
+    imag_row.resize(2*ncols);
+    for (unsigned int j=0, k=op.row_ptr[i]; j<ncols; j++, k++)
+    {
+      cols[2*j]   = 2*op.cols[k];
+      cols[2*j+1] = 2*op.cols[k]+1;
+      real_row[2*j] = sr*op.c0[k] + op.c1[k];  real_row[2*j+1] = -si*op.c0[k];
+      imag_row[2*j] = si*op.c0[k];             imag_row[2*j+1] = sr*op.c0[k] + op.c1[k];
+    }
+
+    const PetscInt real_index = 2*i;
+    const PetscInt imag_index = 2*i+1;
+    ierr = MatSetValues(A, 1, &real_index, 2*ncols, &cols[0], &real_row[0], INSERT_VALUES);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    ierr = MatSetValues(A, 1, &imag_index, 2*ncols, &cols[0], &imag_row[0], INSERT_VALUES);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  }
+
+  ierr = MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+}
+
+
+// Solutions at the given times, one clone of system.solution per time
+// (owned by the caller).
+void laplace_solve (EquationSystems& es, const std::string& system_name,
+                      const std::vector<Real>& times, std::vector<NumericVector<Number>*>& solutions)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  PerfLog perf_log("Laplace solve");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int n_points = es.parameters.get<unsigned int>("talbot_points");
+  const Real dt_saved = es.parameters.get<Real>("dt");
+
+  PetscMatrix<Number>* petsc_matrix = dynamic_cast<PetscMatrix<Number>*>(system.matrix);
+  PetscVector<Number>* petsc_rhs = dynamic_cast<PetscVector<Number>*>(system.rhs);
+
+  // Split K(dt) and F(dt) into the parts constant and linear in dt,
+  // with the load switched on and no history
+  perf_log.push("split");
+  system.old_local_solution->zero();
+  es.parameters.set<Real>("time") = 0;
+  es.parameters.set<Real>("progress") = 1;
+
+  Mat C0, C1;
+  Vec R0, R1;
+
+  es.parameters.set<Real>("dt") = 0.;
+  system.matrix->zero();
+  system.rhs->zero();
+  assemble_stokes(es, system_name);
+  int ierr = MatDuplicate(petsc_matrix->mat(), MAT_COPY_VALUES, &C0);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecDuplicate(petsc_rhs->vec(), &R0);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecCopy(petsc_rhs->vec(), R0);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  es.parameters.set<Real>("dt") = 1.;
+  system.matrix->zero();
+  system.rhs->zero();
+  assemble_stokes(es, system_name);
+  ierr = MatDuplicate(petsc_matrix->mat(), MAT_COPY_VALUES, &C1);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatAXPY(C1, -1., C0, SAME_NONZERO_PATTERN);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecDuplicate(petsc_rhs->vec(), &R1);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecWAXPY(R1, -1., R0, petsc_rhs->vec());
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  es.parameters.set<Real>("dt") = dt_saved;
+  perf_log.pop("split");
+
+  perf_log.push("gather");
+  LaplaceOperator op;
+  gather_laplace_operator(C0, C1, R0, R1, op);
+
+  PetscInt first, last;
+  ierr = MatGetOwnershipRange(C0, &first, &last);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  ierr = LibMeshMatDestroy(&C0);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshMatDestroy(&C1);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshVecDestroy(&R0);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshVecDestroy(&R1);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  perf_log.pop("gather");
+
+  // Processor groups, a contiguous range of ranks each
+  const unsigned int n_procs = libMesh::n_processors();
+  const unsigned int n_groups = std::min(std::min(es.parameters.get<unsigned int>("laplace_groups"), n_procs), n_points);
+  const int group = libMesh::processor_id()*n_groups/n_procs;
+
+  MPI_Comm group_comm;
+  ierr = MPI_Comm_split(libMesh::COMM_WORLD, group, libMesh::processor_id(), &group_comm);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  int group_rank, group_size;
+  MPI_Comm_rank(group_comm, &group_rank);
+  MPI_Comm_size(group_comm, &group_size);
+
+  std::cout<<"Laplace solve in "<< n_groups <<" groups of "<< group_size <<" processors"<<std::endl;
+
+  // The rows of this processor in its group, the real equivalent matrix
+  // keeps the sparsity of C0 (which contains the sparsity of C1) with
+  // 2x2 blocks
+  const PetscInt n_global = op.row_ptr.size()-1;
+  const PetscInt group_first = (static_cast<long long>(n_global)*group_rank)/group_size;
+  const PetscInt group_last = (static_cast<long long>(n_global)*(group_rank+1))/group_size;
+  const PetscInt n_local = group_last-group_first;
+
+  std::vector<PetscInt> d_nnz(2*n_local, 0);
+  std::vector<PetscInt> o_nnz(2*n_local, 0);
+  for (PetscInt i=group_first; i<group_last; i++)
+  {
+    for (unsigned int k=op.row_ptr[i]; k<op.row_ptr[i+1]; k++)
+    {
+      if ((static_cast<PetscInt>(op.cols[k]) >= group_first) && (static_cast<PetscInt>(op.cols[k]) < group_last))
+        d_nnz[2*(i-group_first)] += 2;
+      else
+        o_nnz[2*(i-group_first)] += 2;
+    }
+    d_nnz[2*(i-group_first)+1] = d_nnz[2*(i-group_first)];
+    o_nnz[2*(i-group_first)+1] = o_nnz[2*(i-group_first)];
+  }
+
+  Mat A;
+  ierr = MatCreate(group_comm, &A);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSetSizes(A, 2*n_local, 2*n_local, 2*n_global, 2*n_global);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSetType(A, MATAIJ);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatSeqAIJSetPreallocation(A, 0, &d_nnz[0]);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = MatMPIAIJSetPreallocation(A, 0, &d_nnz[0], 0, &o_nnz[0]);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  Vec b, x;
+  ierr = VecCreateMPI(group_comm, 2*n_local, 2*n_global, &b);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = VecDuplicate(b, &x);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  KSP ksp;
+  PC pc;
+  ierr = KSPCreate(group_comm, &ksp);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPSetType(ksp, KSPPREONLY);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = KSPGetPC(ksp, &pc);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = PCSetType(pc, PC_TYPE);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = PCFactorSetMatSolverPackage(pc, SOLVER_NAME);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+
+  solutions.resize(times.size());
+  std::vector<Real> sum(n_global);
+  for (unsigned int t=0; t<times.size(); t++)
+  {
+    const Real time = times[t];
+    const Real r = 2.*n_points/(5.*time);
+
+    std::cout<<"Laplace solve at time "<< time <<std::endl;
+
+    std::fill(sum.begin(), sum.end(), 0.);
+
+    for (unsigned int k=group; k<n_points; k+=n_groups)
+    {
+      // Contour point and quadrature weight
+      std::complex<Real> s (r, 0.);
+      std::complex<Real> weight (0.5*exp(r*time), 0.);
+      if (k > 0)
+      {
+        const Real theta = k*libMesh::pi/n_points;
+        const Real cot = cos(theta)/sin(theta);
+        const Real sigma = theta + (theta*cot - 1.)*cot;
+        s = std::complex<Real>(r*theta*cot, r*theta);
+        weight = exp(time*s)*std::complex<Real>(1., sigma);
+      }
+      weight *= r/n_points;
+
+      perf_log.push("fill");
+      fill_laplace_matrix(op, A, group_first, group_last, s);
+
+      const std::complex<Real> s_inv = 1./s;
+      PetscScalar *b_array;
+      ierr = VecGetArray(b, &b_array);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      for (PetscInt l=0; l<n_local; l++)
+      {
+        b_array[2*l]   = op.r0[group_first+l] + std::real(s_inv)*op.r1[group_first+l];
+        b_array[2*l+1] = std::imag(s_inv)*op.r1[group_first+l];
+      }
+      ierr = VecRestoreArray(b, &b_array);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      perf_log.pop("fill");
+
+      // Same sparsity for every point, MUMPS only redoes the numerical factorisation
+      perf_log.push("solve");
+      ierr = KSPSetOperators(ksp, A, A, SAME_NONZERO_PATTERN);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      ierr = KSPSolve(ksp, b, x);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      perf_log.pop("solve");
+
+      // x(t) += Re(weight X(s))
+      PetscScalar *x_array;
+      ierr = VecGetArray(x, &x_array);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+      for (PetscInt l=0; l<n_local; l++)
+        sum[group_first+l] += std::real(weight)*x_array[2*l] - std::imag(weight)*x_array[2*l+1];
+      ierr = VecRestoreArray(x, &x_array);
+      CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    }
+
+    // The groups hold disjoint points, their members disjoint rows
+    perf_log.push("sum");
+    Parallel::sum(sum);
+    perf_log.pop("sum");
+
+    solutions[t] = system.solution->clone().release();
+    PetscVector<Number>* petsc_out = dynamic_cast<PetscVector<Number>*>(solutions[t]);
+    PetscScalar *out_array;
+    ierr = VecGetArray(petsc_out->vec(), &out_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    for (PetscInt l=0; l<last-first; l++)
+      out_array[l] = sum[first+l];
+    ierr = VecRestoreArray(petsc_out->vec(), &out_array);
+    CHKERRABORT(libMesh::COMM_WORLD,ierr);
+    solutions[t]->close();
+  }
+
+  ierr = LibMeshKSPDestroy(&ksp);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshMatDestroy(&A);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshVecDestroy(&b);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  ierr = LibMeshVecDestroy(&x);
+  CHKERRABORT(libMesh::COMM_WORLD,ierr);
+  MPI_Comm_free(&group_comm);
+}
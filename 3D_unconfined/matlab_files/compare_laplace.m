@@ -0,0 +1,63 @@
+clear all;
+
+%Radial displacement at the rim probe (probes.in) of the backward Euler
+%run and of the Laplace domain run at the same times, against the Bessel
+%solution.  Runs of scripts/laplace_compare.sh:
+be_file='../data/laplace_compare/cylinder_728sym_20NT_10T_be_probes.dat';
+laplace_file='../data/laplace_compare/cylinder_728sym_20NT_10T_laplace_probes.dat';
+
+%Parameters for simulation (analytical solution), as unconfined_main.m
+params.T=10;
+params.a=1;
+params.v=0.15;
+params.E=1;
+params.lambda=(params.E*params.v)/((1+params.v)*(1-2*params.v));
+params.mu=params.E/(2*(1+params.v));
+params.Hk=params.lambda+2*params.mu;
+params.k=0.1;
+params.tg=1/(params.Hk*params.k/(params.a*params.a));
+params.ez=0.05;
+
+%Radius of the rim probe, the radial displacement is linear in r
+r_probe=0.999;
+
+be=read_probes(be_file);
+laplace=read_probes(laplace_file);
+
+%Bessel solution at the output times
+alpha=find_roots(params.v);
+t=be(:,1);
+anal_y=zeros(size(t));
+for j=1:length(t)
+    summ=0;
+    for i=1:length(alpha)
+        top=exp(-(alpha(i)^2)*(1/params.tg)*t(j));
+        bot=(alpha(i)^2)*((1-params.v)^2)-(1-2*params.v);
+        summ=summ+top/bot;
+    end
+    anal_y(j)=params.v + (1-2*params.v)*(1-params.v)*summ;
+end
+
+%Column 2 is rim:s_u
+be_y=be(:,2)/(r_probe*params.ez);
+laplace_y=laplace(:,2)/(r_probe*params.ez);
+
+be_err=abs(be_y-anal_y);
+laplace_err=abs(laplace_y-anal_y);
+
+fprintf('%10s %12s %12s %12s %12s %12s\n','t/tg','Bessel','BE','Laplace','|BE-Bessel|','|L-Bessel|');
+for j=1:length(t)
+    fprintf('%10.4f %12.6f %12.6f %12.6f %12.3e %12.3e\n',t(j)/params.tg,anal_y(j),be_y(j),laplace_y(j),be_err(j),laplace_err(j));
+end
+fprintf('max error   BE %.3e  Laplace %.3e\n',max(be_err),max(laplace_err));
+fprintf('rms error   BE %.3e  Laplace %.3e\n',sqrt(mean(be_err.^2)),sqrt(mean(laplace_err.^2)));
+fprintf('max |BE-Laplace| %.3e\n',max(abs(be_y-laplace_y)));
+
+figure;
+plot(t/params.tg,anal_y,'k','LineWidth',3);
+hold all
+plot(t/params.tg,be_y,'rx','MarkerSize',14,'LineWidth',2);
+plot(t/params.tg,laplace_y,'bo','MarkerSize',10,'LineWidth',2);
+legend('Bessel','backward Euler','Laplace');
+
+save compare_laplace.mat
@@ -0,0 +1,12 @@
+function [data] = read_probes(file_name)
+%Rows of a probes.cpp time series: time, then the probe values.
+%The % header lines and the column names are skipped.
+
+fid=fopen(file_name);
+line=fgetl(fid);
+while ischar(line) && (isempty(line) || line(1)=='%')
+    line=fgetl(fid);
+end
+n_columns=length(strsplit(strtrim(line)));
+data=fscanf(fid,'%f',[n_columns Inf])';
+fclose(fid);
@@ -5,6 +5,8 @@ tec='.tec';
 
 %numerical solution
 base='/home/scratch/Dropbox/Dphil/libmesh_git/linear_poro_paper/3D_unconfined/data/cylinder_728sym_20NT_10T_1_STAB_';
+%Laplace domain solution at the same times (run with -laplace_times steps)
+%base='/home/scratch/Dropbox/Dphil/libmesh_git/linear_poro_paper/3D_unconfined/data/cylinder_728sym_20NT_10T_1_STAB_laplace_';
 
 
 
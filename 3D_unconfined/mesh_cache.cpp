@@ -0,0 +1,287 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "boundary_info.h"
+#include "elem.h"
+#include "gmsh_io.h"
+
+#include "assemble.h"
+
+// Binary cache of the prepared mesh, mesh_file_name + ".cache".
+//
+// The Gmsh file is parsed, prepared and (without PRES_STAB) made second
+// order once, later runs map the cache and add the nodes, elements and
+// boundary ids directly,
+//
+//   -no_mesh_cache   always read the Gmsh file
+//
+// The cache is keyed by a hash of the Gmsh file and the mesh options, a
+// changed file or configuration rebuilds it.  Node and element ids are
+// kept, so the dof numbering and the results are those of the Gmsh read.
+// prepare_for_use still finds the neighbours and partitions the mesh,
+// both are cheap next to the parse and all_second_order.
+//
+// Layout: a MeshCacheHeader, then
+//   Real     points[n_nodes][3]
+//   uint32_t elem_type[n_elem], elem_subdomain[n_elem]
+//   uint64_t elem_start[n_elem+1]
+//   uint32_t elem_nodes[n_connectivity]
+//   uint32_t side_elem[n_sides], side_side[n_sides]
+//   int32_t  side_id[n_sides]
+//   uint32_t bc_node[n_bc_nodes]
+//   int32_t  bc_node_id[n_bc_nodes]
+
+struct MeshCacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t real_size;
+  uint64_t key;
+
+  uint32_t dim;
+  uint32_t second_order;
+  uint64_t n_nodes;
+  uint64_t n_elem;
+  uint64_t n_connectivity;
+  uint64_t n_sides;
+  uint64_t n_bc_nodes;
+};
+
+static const char mesh_cache_magic[8] = {'P','O','R','O','M','S','H','\0'};
+
+
+// FNV-1a of the Gmsh file and the mesh options, 0 if the file cannot be read
+uint64_t mesh_cache_key (const std::string& mesh_file_name)
+{
+  const int fd = open(mesh_file_name.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if ( (fd < 0) || (fstat(fd, &file_stat) != 0) || (file_stat.st_size == 0) )
+  {
+    if (fd >= 0)
+      close(fd);
+    return 0;
+  }
+
+  void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return 0;
+
+  uint64_t key = 14695981039346656037ULL;
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (off_t i=0; i<file_stat.st_size; i++)
+    key = (key ^ bytes[i]) * 1099511628211ULL;
+  munmap(data, file_stat.st_size);
+
+  const uint32_t options[2] = {THREED, PRES_STAB};
+  for (unsigned int i=0; i<sizeof(options); i++)
+    key = (key ^ reinterpret_cast<const unsigned char*>(options)[i]) * 1099511628211ULL;
+
+  return key;
+}
+
+
+template <typename T>
+inline void mesh_cache_write (FILE* file, const std::vector<T>& array, bool& ok)
+{
+  if (!array.empty())
+    ok = ok && (std::fwrite(&array[0], sizeof(T), array.size(), file) == array.size());
+}
+
+void write_mesh_cache (const MeshBase& mesh, const std::string& cache_file_name, const uint64_t key)
+{
+  MeshCacheHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, mesh_cache_magic, sizeof(header.magic));
+  header.version = 1;
+  header.real_size = sizeof(Real);
+  header.key = key;
+  header.dim = mesh.mesh_dimension();
+  header.second_order = !PRES_STAB;
+  header.n_nodes = mesh.n_nodes();
+  header.n_elem = mesh.n_elem();
+
+  std::vector<Real> points(3*mesh.n_nodes());
+  for (unsigned int n=0; n<mesh.n_nodes(); n++)
+    for (unsigned int d=0; d<3; d++)
+      points[3*n+d] = mesh.point(n)(d);
+
+  std::vector<uint32_t> elem_type(mesh.n_elem()), elem_subdomain(mesh.n_elem());
+  std::vector<uint64_t> elem_start(mesh.n_elem()+1, 0);
+  std::vector<uint32_t> elem_nodes;
+  for (unsigned int e=0; e<mesh.n_elem(); e++)
+  {
+    const Elem* elem = mesh.elem(e);
+    elem_type[e] = elem->type();
+    elem_subdomain[e] = elem->subdomain_id();
+    for (unsigned int n=0; n<elem->n_nodes(); n++)
+      elem_nodes.push_back(elem->node(n));
+    elem_start[e+1] = elem_nodes.size();
+  }
+  header.n_connectivity = elem_nodes.size();
+
+  std::vector<unsigned int> side_elem_list;
+  std::vector<unsigned short int> side_list;
+  std::vector<short int> side_id_list;
+  mesh.boundary_info->build_side_list(side_elem_list, side_list, side_id_list);
+  const std::vector<uint32_t> side_elem(side_elem_list.begin(), side_elem_list.end());
+  const std::vector<uint32_t> side_side(side_list.begin(), side_list.end());
+  const std::vector<int32_t> side_id(side_id_list.begin(), side_id_list.end());
+  header.n_sides = side_elem.size();
+
+  std::vector<unsigned int> node_list;
+  std::vector<short int> node_id_list;
+  mesh.boundary_info->build_node_list(node_list, node_id_list);
+  const std::vector<uint32_t> bc_node(node_list.begin(), node_list.end());
+  const std::vector<int32_t> bc_node_id(node_id_list.begin(), node_id_list.end());
+  header.n_bc_nodes = bc_node.size();
+
+  // Concurrent runs of a sweep may build the same cache
+  std::stringstream tmp_name;
+  tmp_name << cache_file_name << ".tmp" << getpid();
+  FILE* file = std::fopen(tmp_name.str().c_str(), "wb");
+  if (file == NULL)
+  {
+    std::cerr<<"Cannot write mesh cache "<< tmp_name.str() <<std::endl;
+    return;
+  }
+
+  bool ok = (std::fwrite(&header, sizeof(header), 1, file) == 1);
+  mesh_cache_write(file, points, ok);
+  mesh_cache_write(file, elem_type, ok);
+  mesh_cache_write(file, elem_subdomain, ok);
+  mesh_cache_write(file, elem_start, ok);
+  mesh_cache_write(file, elem_nodes, ok);
+  mesh_cache_write(file, side_elem, ok);
+  mesh_cache_write(file, side_side, ok);
+  mesh_cache_write(file, side_id, ok);
+  mesh_cache_write(file, bc_node, ok);
+  mesh_cache_write(file, bc_node_id, ok);
+  ok = (std::fclose(file) == 0) && ok;
+
+  if (!ok || (std::rename(tmp_name.str().c_str(), cache_file_name.c_str()) != 0))
+  {
+    std::cerr<<"Cannot write mesh cache "<< cache_file_name <<std::endl;
+    std::remove(tmp_name.str().c_str());
+    return;
+  }
+
+  std::cout<<"Wrote mesh cache "<< cache_file_name <<std::endl;
+}
+
+
+template <typename T>
+inline const T* mesh_cache_array (const char*& position, const uint64_t size)
+{
+  const T* array = reinterpret_cast<const T*>(position);
+  position += size*sizeof(T);
+  return array;
+}
+
+// Builds the mesh from the cache, false (and the mesh untouched) if the
+// cache is missing or stale
+bool read_mesh_cache (MeshBase& mesh, const std::string& cache_file_name, const uint64_t key)
+{
+  const int fd = open(cache_file_name.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if ( (fd < 0) || (fstat(fd, &file_stat) != 0) || (static_cast<size_t>(file_stat.st_size) < sizeof(MeshCacheHeader)) )
+  {
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+
+  void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  const MeshCacheHeader& header = *static_cast<const MeshCacheHeader*>(data);
+  const uint64_t size = sizeof(MeshCacheHeader) + 3*header.n_nodes*sizeof(Real) +
+    2*header.n_elem*sizeof(uint32_t) + (header.n_elem+1)*sizeof(uint64_t) + header.n_connectivity*sizeof(uint32_t) +
+    3*header.n_sides*sizeof(uint32_t) + 2*header.n_bc_nodes*sizeof(uint32_t);
+
+  if ( (std::memcmp(header.magic, mesh_cache_magic, sizeof(header.magic)) != 0) || (header.version != 1) ||
+       (header.real_size != sizeof(Real)) || (header.key != key) || (header.dim != mesh.mesh_dimension()) ||
+       (static_cast<uint64_t>(file_stat.st_size) != size) )
+  {
+    munmap(data, file_stat.st_size);
+    return false;
+  }
+
+  const char* position = static_cast<const char*>(data) + sizeof(MeshCacheHeader);
+  const Real* points = mesh_cache_array<Real>(position, 3*header.n_nodes);
+  const uint32_t* elem_type = mesh_cache_array<uint32_t>(position, header.n_elem);
+  const uint32_t* elem_subdomain = mesh_cache_array<uint32_t>(position, header.n_elem);
+  const uint64_t* elem_start = mesh_cache_array<uint64_t>(position, header.n_elem+1);
+  const uint32_t* elem_nodes = mesh_cache_array<uint32_t>(position, header.n_connectivity);
+  const uint32_t* side_elem = mesh_cache_array<uint32_t>(position, header.n_sides);
+  const uint32_t* side_side = mesh_cache_array<uint32_t>(position, header.n_sides);
+  const int32_t* side_id = mesh_cache_array<int32_t>(position, header.n_sides);
+  const uint32_t* bc_node = mesh_cache_array<uint32_t>(position, header.n_bc_nodes);
+  const int32_t* bc_node_id = mesh_cache_array<int32_t>(position, header.n_bc_nodes);
+
+  mesh.reserve_nodes(header.n_nodes);
+  mesh.reserve_elem(header.n_elem);
+
+  for (unsigned int n=0; n<header.n_nodes; n++)
+    mesh.add_point(Point(points[3*n], points[3*n+1], points[3*n+2]), n);
+
+  for (unsigned int e=0; e<header.n_elem; e++)
+  {
+    Elem* elem = Elem::build(static_cast<ElemType>(elem_type[e])).release();
+    elem->set_id(e);
+    elem->subdomain_id() = elem_subdomain[e];
+    for (uint64_t k=elem_start[e]; k<elem_start[e+1]; k++)
+      elem->set_node(k-elem_start[e]) = mesh.node_ptr(elem_nodes[k]);
+    mesh.add_elem(elem);
+  }
+
+  for (unsigned int s=0; s<header.n_sides; s++)
+    mesh.boundary_info->add_side(mesh.elem(side_elem[s]), side_side[s], side_id[s]);
+  for (unsigned int n=0; n<header.n_bc_nodes; n++)
+    mesh.boundary_info->add_node(mesh.node_ptr(bc_node[n]), bc_node_id[n]);
+
+  munmap(data, file_stat.st_size);
+
+  mesh.prepare_for_use();
+  return true;
+}
+
+
+// Reads the Gmsh file mesh_file_name, prepared and with the element
+// order of the configuration, through the cache
+void read_mesh (MeshBase& mesh, const std::string& mesh_file_name)
+{
+  const std::string cache_file_name = mesh_file_name + ".cache";
+  const bool use_cache = !on_command_line("-no_mesh_cache");
+  const uint64_t key = use_cache ? mesh_cache_key(mesh_file_name) : 0;
+
+  if (use_cache && (key != 0) && read_mesh_cache(mesh, cache_file_name, key))
+  {
+    std::cout<<"Mesh from cache "<< cache_file_name <<std::endl;
+    return;
+  }
+
+  GmshIO(mesh).read(mesh_file_name);
+  mesh.prepare_for_use();
+  #if !PRES_STAB
+  mesh.all_second_order(); //Need fpr P2
+  #endif
+
+  if (use_cache && (key != 0) && (libMesh::processor_id() == 0))
+    write_mesh_cache(mesh, cache_file_name, key);
+}
@@ -0,0 +1,616 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <deque>
+#include <cstdio>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "exodusII_io_helper.h"
+#include "tecplot_io.h"
+#include "elem.h"
+
+#include "assemble.h"
+
+// Output of the steps of a run: one Exodus file, result_file_name + ".e"
+// (or "_laplace.e" for the Laplace domain solve), with WRITE_XDMF a binary
+// XDMF pair result_file_name + ".bin"/".xmf", and with WRITE_TEC one
+// Tecplot file per step.
+//
+// The Exodus and XDMF meshes are written once when the files are created,
+// every written step appends a time and the values of the selected
+// variables only,
+//
+//   -output_variables "s_u s_v s_p"   variables to write (default all)
+//   -output_stride 4                  write every 4th step (default 1)
+//   -output_queue 2                   steps waiting for the writer (default 2)
+//   -output_precision 4               bytes per XDMF value, 4 or 8 (default 8)
+//
+// The XDMF heavy data file holds the coordinates and the connectivity,
+// then the arrays of every step, appended contiguously.  The .xmf index
+// refers to them by offset; it is rewritten after every step, so
+// ParaView can open a running simulation.
+//
+// The bytes written and the wall time of every path are reported per
+// step and summed by close_output, scripts/output_costs.sh tabulates
+// them for the three paths.
+//
+// Element (CONSTANT MONOMIAL) variables such as the P0 pressure keep
+// their per element values: Exodus element variables and XDMF cell
+// attributes, from get_solution.  The Tecplot files hold nodal values
+// only, there they are the nodal averages of build_solution_vector.
+//
+// write_output only gathers the solution (collective) into a buffer from
+// a pool and queues it.  The files are written by a background thread on
+// processor 0 while the next step is assembled and solved.  When
+// -output_queue steps are waiting, write_output blocks until the writer
+// has caught up; with -output_queue 0 every step is written at once.
+
+// Bytes and wall time of one output path
+struct OutputCost
+{
+  const char* name;
+  Real bytes;
+  Real seconds;
+  unsigned int steps;
+};
+
+// Gathered values of one step, nodal (build_solution_vector) and
+// element (get_solution)
+struct OutputData
+{
+  std::vector<Number> nodal;
+  std::vector<Number> element;
+};
+
+struct OutputJob
+{
+  unsigned int step;
+  Real time;
+  OutputData* data;
+};
+
+struct OutputWriter
+{
+  std::string file_name;
+  std::string xdmf_name;
+  std::string tec_prefix;
+
+  // Selected variables and their columns in build_solution_vector
+  std::vector<std::string> names;
+  std::vector<unsigned int> columns;
+
+  // Of these, the nodal ones, and the element ones with their index
+  // in get_solution
+  std::vector<std::string> nodal_names;
+  std::vector<unsigned int> nodal_columns;
+  std::vector<std::string> element_names;
+  std::vector<unsigned int> element_index;
+
+  unsigned int stride;
+  unsigned int depth;
+  int n_written;
+
+  const MeshBase* mesh;
+#ifdef LIBMESH_HAVE_EXODUS_API
+  ExodusII_IO_Helper* helper;
+#endif
+
+  // XDMF heavy data file, offsets of the mesh and of every step's arrays
+  FILE* xdmf_file;
+  unsigned int precision;
+  unsigned long long xdmf_offset;
+  unsigned long long geometry_offset;
+  unsigned long long topology_offset;
+  unsigned long long topology_size;
+  unsigned int n_elem;
+  std::vector<Real> xdmf_times;
+  std::vector<unsigned long long> xdmf_offsets;
+
+  OutputCost exodus_cost, xdmf_cost, tec_cost;
+
+  // Background writer on processor 0
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+  std::deque<OutputJob> queue;
+  std::vector<OutputData*> pool;
+  bool finished;
+};
+
+OutputWriter output_writer;
+
+
+Real output_wall_time ()
+{
+  timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec + 1.e-6*now.tv_usec;
+}
+
+
+Real output_file_size (const std::string& file_name)
+{
+  struct stat file_stat;
+  return (stat(file_name.c_str(), &file_stat) == 0) ? Real(file_stat.st_size) : 0.;
+}
+
+
+void add_output_cost (OutputCost& cost, const Real bytes, const Real seconds)
+{
+  cost.bytes += bytes;
+  cost.seconds += seconds;
+  cost.steps++;
+  std::cout<<"  "<< cost.name <<" "<< bytes <<" bytes, "<< seconds <<" s"<<std::endl;
+}
+
+
+// Appends values to the XDMF heavy data file in the output precision
+void write_xdmf_values (const std::vector<Real>& values)
+{
+  if (output_writer.precision == 4)
+  {
+    std::vector<float> single(values.begin(), values.end());
+    std::fwrite(&single[0], sizeof(float), single.size(), output_writer.xdmf_file);
+  }
+  else
+    std::fwrite(&values[0], sizeof(Real), values.size(), output_writer.xdmf_file);
+
+  output_writer.xdmf_offset += values.size()*output_writer.precision;
+}
+
+
+// Coordinates and a Mixed topology: XDMF type code then the nodes of
+// every element.  libMesh and XDMF order the nodes of the linear
+// elements, TRI6 and TET10 alike, other elements are written by their
+// vertices.
+void write_xdmf_mesh (const MeshBase& mesh)
+{
+  std::vector<Real> points(3*mesh.n_nodes());
+  for (unsigned int n=0; n<mesh.n_nodes(); n++)
+    for (unsigned int d=0; d<3; d++)
+      points[3*n+d] = mesh.point(n)(d);
+
+  std::vector<int> topology;
+  for (unsigned int e=0; e<mesh.n_elem(); e++)
+  {
+    const Elem* elem = mesh.elem(e);
+    unsigned int n_nodes = elem->n_vertices();
+    switch (elem->type())
+    {
+      case TRI6:   topology.push_back(36); n_nodes = 6;  break;
+      case TET10:  topology.push_back(38); n_nodes = 10; break;
+      case TRI3:   topology.push_back(4);  break;
+      case QUAD4:  case QUAD8: case QUAD9:
+                   topology.push_back(5);  break;
+      case TET4:   topology.push_back(6);  break;
+      case PYRAMID5:
+                   topology.push_back(7);  break;
+      case PRISM6: case PRISM15: case PRISM18:
+                   topology.push_back(8);  break;
+      case HEX8:   case HEX20: case HEX27:
+                   topology.push_back(9);  break;
+      default:
+        std::cerr<<"No XDMF topology for element type "<< elem->type() <<std::endl;
+        libmesh_error();
+    }
+    for (unsigned int n=0; n<n_nodes; n++)
+      topology.push_back(elem->node(n));
+  }
+
+  output_writer.n_elem = mesh.n_elem();
+
+  output_writer.geometry_offset = output_writer.xdmf_offset;
+  write_xdmf_values(points);
+
+  // The topology is always 4 byte integers
+  output_writer.topology_offset = output_writer.xdmf_offset;
+  output_writer.topology_size = topology.size();
+  std::fwrite(&topology[0], sizeof(int), topology.size(), output_writer.xdmf_file);
+  output_writer.xdmf_offset += topology.size()*sizeof(int);
+}
+
+
+// One scalar attribute of the XDMF index, advances offset past its array
+void write_xdmf_attribute (std::ofstream& index, const std::string& name, const char* center,
+                           const unsigned int size, unsigned long long& offset)
+{
+  const std::string heavy_name = output_writer.xdmf_name + ".bin";
+  const std::string heavy_file = heavy_name.substr(heavy_name.find_last_of('/')+1);
+
+  index << "    <Attribute Name=\"" << name << "\" AttributeType=\"Scalar\" Center=\"" << center << "\">\n";
+  index << "     <DataItem Format=\"Binary\" Endian=\"Native\" NumberType=\"Float\" Precision=\"" << output_writer.precision
+        << "\" Seek=\"" << offset << "\" Dimensions=\"" << size << "\">"
+        << heavy_file << "</DataItem>\n";
+  index << "    </Attribute>\n";
+  offset += size*output_writer.precision;
+}
+
+
+// Rewrites the XML index of all steps written so far
+void write_xdmf_index (const unsigned int n_nodes)
+{
+  const std::string heavy_name = output_writer.xdmf_name + ".bin";
+  const std::string heavy_file = heavy_name.substr(heavy_name.find_last_of('/')+1);
+  const std::string index_name = output_writer.xdmf_name + ".xmf";
+  const std::string tmp_name = index_name + ".tmp";
+  const unsigned int precision = output_writer.precision;
+
+  std::ofstream index(tmp_name.c_str());
+  index << std::setprecision(12);
+  index << "<?xml version=\"1.0\" ?>\n";
+  index << "<Xdmf Version=\"2.0\">\n <Domain>\n";
+  index << "  <Grid Name=\"steps\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+
+  for (unsigned int t=0; t<output_writer.xdmf_times.size(); t++)
+  {
+    index << "   <Grid Name=\"step_" << t << "\" GridType=\"Uniform\">\n";
+    index << "    <Time Value=\"" << output_writer.xdmf_times[t] << "\"/>\n";
+    index << "    <Topology TopologyType=\"Mixed\" NumberOfElements=\"" << output_writer.n_elem << "\">\n";
+    index << "     <DataItem Format=\"Binary\" Endian=\"Native\" NumberType=\"Int\" Precision=\"4\" Seek=\""
+          << output_writer.topology_offset << "\" Dimensions=\"" << output_writer.topology_size << "\">"
+          << heavy_file << "</DataItem>\n";
+    index << "    </Topology>\n";
+    index << "    <Geometry GeometryType=\"XYZ\">\n";
+    index << "     <DataItem Format=\"Binary\" Endian=\"Native\" NumberType=\"Float\" Precision=\"" << precision
+          << "\" Seek=\"" << output_writer.geometry_offset << "\" Dimensions=\"" << n_nodes << " 3\">"
+          << heavy_file << "</DataItem>\n";
+    index << "    </Geometry>\n";
+
+    unsigned long long offset = output_writer.xdmf_offsets[t];
+    for (unsigned int k=0; k<output_writer.nodal_names.size(); k++)
+      write_xdmf_attribute(index, output_writer.nodal_names[k], "Node", n_nodes, offset);
+    for (unsigned int k=0; k<output_writer.element_names.size(); k++)
+      write_xdmf_attribute(index, output_writer.element_names[k], "Cell", output_writer.n_elem, offset);
+    index << "   </Grid>\n";
+  }
+
+  index << "  </Grid>\n </Domain>\n</Xdmf>\n";
+  index.close();
+
+  std::rename(tmp_name.c_str(), index_name.c_str());
+}
+
+
+// Writes one gathered step, in the writer thread or directly
+void write_output_job (const OutputJob& job)
+{
+  const MeshBase& mesh = *output_writer.mesh;
+  const std::vector<Number>& soln = job.data->nodal;
+  const std::vector<Number>& element_soln = job.data->element;
+
+  const unsigned int n_nodes = mesh.n_nodes();
+  const unsigned int n_elem = mesh.n_elem();
+  const unsigned int n_vars = soln.size()/n_nodes;
+  const unsigned int n_nodal = output_writer.nodal_columns.size();
+  const unsigned int n_element = output_writer.element_index.size();
+
+  std::cout<<"output step "<< job.step <<", time "<< job.time <<std::endl;
+
+#ifdef LIBMESH_HAVE_EXODUS_API
+  Real start = output_wall_time();
+  const Real exodus_size = output_file_size(output_writer.file_name);
+
+  if (output_writer.helper == NULL)
+  {
+    output_writer.helper = new ExodusII_IO_Helper;
+    output_writer.helper->create(output_writer.file_name);
+    output_writer.helper->initialize(output_writer.file_name, mesh);
+    output_writer.helper->write_nodal_coordinates(mesh);
+    output_writer.helper->write_elements(mesh);
+    output_writer.helper->initialize_nodal_variables(output_writer.nodal_names);
+    if (n_element > 0)
+      output_writer.helper->initialize_element_variables(mesh, output_writer.element_names);
+  }
+
+  output_writer.n_written++;
+  output_writer.helper->write_timestep(output_writer.n_written, job.time);
+
+  std::vector<Number> values(n_nodes);
+  for (unsigned int k=0; k<n_nodal; k++)
+  {
+    for (unsigned int i=0; i<n_nodes; i++)
+      values[i] = soln[i*n_vars + output_writer.nodal_columns[k]];
+    output_writer.helper->write_nodal_values(k+1, values, output_writer.n_written);
+  }
+
+  // get_solution and write_element_values both order by variable, then element id
+  if (n_element > 0)
+  {
+    std::vector<Number> element_values(n_element*n_elem);
+    for (unsigned int k=0; k<n_element; k++)
+      std::copy(element_soln.begin() + output_writer.element_index[k]*n_elem,
+                element_soln.begin() + (output_writer.element_index[k]+1)*n_elem,
+                element_values.begin() + k*n_elem);
+    output_writer.helper->write_element_values(mesh, element_values, output_writer.n_written);
+  }
+
+  // The Exodus library buffers, the size is that of the file so far
+  add_output_cost(output_writer.exodus_cost, output_file_size(output_writer.file_name) - exodus_size, output_wall_time() - start);
+#endif
+
+#if WRITE_XDMF
+  Real xdmf_start = output_wall_time();
+  const unsigned long long xdmf_offset = output_writer.xdmf_offset;
+
+  if (output_writer.xdmf_file == NULL)
+  {
+    const std::string heavy_name = output_writer.xdmf_name + ".bin";
+    output_writer.xdmf_file = std::fopen(heavy_name.c_str(), "wb");
+    if (output_writer.xdmf_file == NULL)
+    {
+      std::cerr<<"Cannot write "<< heavy_name <<std::endl;
+      libmesh_error();
+    }
+    write_xdmf_mesh(mesh);
+  }
+
+  output_writer.xdmf_times.push_back(job.time);
+  output_writer.xdmf_offsets.push_back(output_writer.xdmf_offset);
+
+  std::vector<Real> column(n_nodes);
+  for (unsigned int k=0; k<n_nodal; k++)
+  {
+    for (unsigned int i=0; i<n_nodes; i++)
+      column[i] = libmesh_real(soln[i*n_vars + output_writer.nodal_columns[k]]);
+    write_xdmf_values(column);
+  }
+
+  std::vector<Real> cells(n_elem);
+  for (unsigned int k=0; k<n_element; k++)
+  {
+    for (unsigned int e=0; e<n_elem; e++)
+      cells[e] = libmesh_real(element_soln[output_writer.element_index[k]*n_elem + e]);
+    write_xdmf_values(cells);
+  }
+
+  // The index only refers to data on disk
+  std::fflush(output_writer.xdmf_file);
+  write_xdmf_index(n_nodes);
+
+  add_output_cost(output_writer.xdmf_cost, output_writer.xdmf_offset - xdmf_offset +
+    output_file_size(output_writer.xdmf_name + ".xmf"), output_wall_time() - xdmf_start);
+#endif
+
+#if WRITE_TEC
+  Real tec_start = output_wall_time();
+  const unsigned int n_selected = output_writer.columns.size();
+
+  std::vector<Number> selected(n_nodes*n_selected);
+  for (unsigned int i=0; i<n_nodes; i++)
+    for (unsigned int k=0; k<n_selected; k++)
+      selected[i*n_selected + k] = soln[i*n_vars + output_writer.columns[k]];
+
+  std::stringstream file_name_tec;
+  file_name_tec << output_writer.tec_prefix << job.step << ".tec" ;
+  TecplotIO(mesh).write_nodal_data(file_name_tec.str(), selected, output_writer.names);
+
+  add_output_cost(output_writer.tec_cost, output_file_size(file_name_tec.str()), output_wall_time() - tec_start);
+#endif
+}
+
+
+void* output_writer_thread (void*)
+{
+  pthread_mutex_lock(&output_writer.mutex);
+  for (;;)
+  {
+    while (output_writer.queue.empty() && !output_writer.finished)
+      pthread_cond_wait(&output_writer.changed, &output_writer.mutex);
+    if (output_writer.queue.empty())
+      break;
+
+    const OutputJob job = output_writer.queue.front();
+    pthread_mutex_unlock(&output_writer.mutex);
+
+    write_output_job(job);
+
+    pthread_mutex_lock(&output_writer.mutex);
+    output_writer.queue.pop_front();
+    output_writer.pool.push_back(job.data);
+    pthread_cond_broadcast(&output_writer.changed);
+  }
+  pthread_mutex_unlock(&output_writer.mutex);
+
+  return NULL;
+}
+
+
+void open_output (EquationSystems& es, const std::string& file_name, const std::string& tec_prefix)
+{
+  output_writer.file_name = file_name;
+  output_writer.tec_prefix = tec_prefix;
+  output_writer.stride = std::max(command_line_value("-output_stride", 1), 1);
+  output_writer.depth = command_line_value("-output_queue", 2);
+  output_writer.n_written = 0;
+  output_writer.mesh = &es.get_mesh();
+#ifdef LIBMESH_HAVE_EXODUS_API
+  output_writer.helper = NULL;
+#endif
+
+  // The XDMF files are named after the Exodus file
+  output_writer.xdmf_name = file_name.substr(0, file_name.rfind(".e"));
+  output_writer.xdmf_file = NULL;
+  output_writer.precision = (command_line_value("-output_precision", 8) == 4) ? 4 : sizeof(Real);
+  output_writer.xdmf_offset = 0;
+  output_writer.xdmf_times.clear();
+  output_writer.xdmf_offsets.clear();
+
+  const OutputCost no_cost = {"", 0., 0., 0};
+  output_writer.exodus_cost = no_cost;
+  output_writer.exodus_cost.name = "exodus";
+  output_writer.xdmf_cost = no_cost;
+  output_writer.xdmf_cost.name = "xdmf";
+  output_writer.tec_cost = no_cost;
+  output_writer.tec_cost.name = "tecplot";
+
+  std::vector<std::string> all_names;
+  es.build_variable_names(all_names);
+
+  std::vector<std::string> selected;
+  std::istringstream list(command_line_value("-output_variables", std::string()));
+  std::string name;
+  while (list >> name)
+    selected.push_back(name);
+
+  output_writer.names.clear();
+  output_writer.columns.clear();
+  for (unsigned int c=0; c<all_names.size(); c++)
+    if (selected.empty() || (std::find(selected.begin(), selected.end(), all_names[c]) != selected.end()))
+    {
+      output_writer.names.push_back(all_names[c]);
+      output_writer.columns.push_back(c);
+    }
+
+  // The element variables are those get_solution returns (collective)
+  std::vector<Number> element_soln;
+  std::vector<std::string> element_names;
+  es.get_solution(element_soln, element_names);
+
+  output_writer.nodal_names.clear();
+  output_writer.nodal_columns.clear();
+  output_writer.element_names.clear();
+  output_writer.element_index.clear();
+  for (unsigned int k=0; k<output_writer.names.size(); k++)
+  {
+    const std::vector<std::string>::const_iterator it =
+      std::find(element_names.begin(), element_names.end(), output_writer.names[k]);
+    if (it == element_names.end())
+    {
+      output_writer.nodal_names.push_back(output_writer.names[k]);
+      output_writer.nodal_columns.push_back(output_writer.columns[k]);
+    }
+    else
+    {
+      output_writer.element_names.push_back(output_writer.names[k]);
+      output_writer.element_index.push_back(it - element_names.begin());
+    }
+  }
+
+  for (unsigned int k=0; k<selected.size(); k++)
+    if (std::find(all_names.begin(), all_names.end(), selected[k]) == all_names.end())
+      std::cerr<<"Unknown output variable "<< selected[k] <<std::endl;
+
+  if ( (libMesh::processor_id() != 0) || (output_writer.depth == 0) )
+    return;
+
+  output_writer.finished = false;
+  pthread_mutex_init(&output_writer.mutex, NULL);
+  pthread_cond_init(&output_writer.changed, NULL);
+  if (pthread_create(&output_writer.thread, NULL, output_writer_thread, NULL) != 0)
+  {
+    std::cerr<<"Cannot start the output thread"<<std::endl;
+    libmesh_error();
+  }
+}
+
+
+// Gathers the values of a step, collective
+void gather_output (EquationSystems& es, OutputData& data)
+{
+  es.build_solution_vector(data.nodal);
+
+  data.element.clear();
+  if (!output_writer.element_names.empty())
+  {
+    std::vector<std::string> element_names;
+    es.get_solution(data.element, element_names);
+  }
+}
+
+
+// Queues step "step" at "time" if it falls on the output stride
+void write_output (EquationSystems& es, const unsigned int step, const Real time)
+{
+  if (step % output_writer.stride != 0)
+    return;
+
+  OutputJob job;
+  job.step = step;
+  job.time = time;
+
+  if ( (libMesh::processor_id() != 0) || (output_writer.depth == 0) )
+  {
+    // Collective, only processor 0 writes
+    OutputData data;
+    gather_output(es, data);
+    if (libMesh::processor_id() == 0)
+    {
+      job.data = &data;
+      write_output_job(job);
+    }
+    return;
+  }
+
+  // Back-pressure, and a free buffer
+  pthread_mutex_lock(&output_writer.mutex);
+  while (output_writer.queue.size() >= output_writer.depth)
+    pthread_cond_wait(&output_writer.changed, &output_writer.mutex);
+  if (output_writer.pool.empty())
+    job.data = new OutputData;
+  else
+  {
+    job.data = output_writer.pool.back();
+    output_writer.pool.pop_back();
+  }
+  pthread_mutex_unlock(&output_writer.mutex);
+
+  gather_output(es, *job.data);
+
+  pthread_mutex_lock(&output_writer.mutex);
+  output_writer.queue.push_back(job);
+  pthread_cond_broadcast(&output_writer.changed);
+  pthread_mutex_unlock(&output_writer.mutex);
+}
+
+
+// Waits for the queued steps and closes the files
+void close_output ()
+{
+  if ( (libMesh::processor_id() == 0) && (output_writer.depth > 0) )
+  {
+    pthread_mutex_lock(&output_writer.mutex);
+    output_writer.finished = true;
+    pthread_cond_broadcast(&output_writer.changed);
+    pthread_mutex_unlock(&output_writer.mutex);
+    pthread_join(output_writer.thread, NULL);
+
+    for (unsigned int k=0; k<output_writer.pool.size(); k++)
+      delete output_writer.pool[k];
+    output_writer.pool.clear();
+    pthread_cond_destroy(&output_writer.changed);
+    pthread_mutex_destroy(&output_writer.mutex);
+  }
+
+#ifdef LIBMESH_HAVE_EXODUS_API
+  if (output_writer.helper != NULL)
+  {
+    output_writer.helper->close();
+    delete output_writer.helper;
+    output_writer.helper = NULL;
+  }
+#endif
+
+  if (output_writer.xdmf_file != NULL)
+  {
+    std::fclose(output_writer.xdmf_file);
+    output_writer.xdmf_file = NULL;
+    std::cout<<"Wrote "<< output_writer.xdmf_name <<".xmf"<<std::endl;
+  }
+
+  const OutputCost* costs[3] = {&output_writer.exodus_cost, &output_writer.xdmf_cost, &output_writer.tec_cost};
+  for (unsigned int c=0; c<3; c++)
+    if (costs[c]->steps > 0)
+      std::cout<<"Output "<< costs[c]->name <<": "<< costs[c]->steps <<" steps, "
+               << costs[c]->bytes/costs[c]->steps <<" bytes and "<< costs[c]->seconds/costs[c]->steps <<" s per step"<<std::endl;
+}
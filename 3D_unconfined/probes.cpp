@@ -0,0 +1,197 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "fe_interface.h"
+#include "dof_map.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "point_locator_base.h"
+#include "elem.h"
+#include "parallel.h"
+#include "getpot.h"
+
+#include "assemble.h"
+
+// Point values of Last_non_linear_soln over time, for validation runs
+// that do not need the full field output.
+//
+// -probe_file <file> reads the probe points from a GetPot input file, see
+// probes.in,
+//   probes      names of the probes
+//   [name]
+//     point     x y z
+//     variables variables to record (default all)
+//
+// Every point is located once with the point locator of the mesh, its
+// element, reference coordinates, dof indices and shape function values
+// are kept, so a step only sums phi_i u_i.  The processor owning the
+// element evaluates a probe.  The time series goes to
+// result_file_name + "_probes.dat", a header of comment lines with the
+// element and reference point of every probe, then one row per step,
+//   time name:variable ...
+
+struct ProbeValue
+{
+  std::string name;
+  std::vector<unsigned int> dof_indices;
+  std::vector<Real> phi;
+};
+
+struct Probe
+{
+  std::string name;
+  Point point;
+  const Elem* elem;
+  Point reference_point;
+  std::vector<ProbeValue> values;
+};
+
+struct ProbeSet
+{
+  std::vector<Probe> probes;
+  unsigned int n_values;
+  std::ofstream file;
+};
+
+ProbeSet probe_set;
+
+
+void setup_probes (EquationSystems& es, const std::string& file_name)
+{
+  probe_set.probes.clear();
+  probe_set.n_values = 0;
+
+  const std::string probe_file = command_line_value("-probe_file", std::string(""));
+  if (probe_file == "")
+    return;
+
+  const MeshBase& mesh = es.get_mesh();
+  const unsigned int dim = mesh.mesh_dimension();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+  const DofMap & dof_map = system.get_dof_map();
+
+  GetPot input(probe_file.c_str());
+  const PointLocatorBase& locator = mesh.point_locator();
+
+  for (unsigned int k=0; k<input.vector_variable_size("probes"); k++)
+  {
+    Probe probe;
+    probe.name = input("probes", "", k);
+    const std::string section = probe.name + "/";
+
+    for (unsigned int d=0; d<dim; d++)
+      probe.point(d) = input((section+"point").c_str(), 0., d);
+
+    probe.elem = locator(probe.point);
+    if (probe.elem == NULL)
+    {
+      std::cerr<<"Probe "<< probe.name <<" at "<< probe.point <<" is outside the mesh"<<std::endl;
+      libmesh_error();
+    }
+
+    std::vector<unsigned int> vars;
+    const std::string variables_name = section + "variables";
+    for (unsigned int v=0; v<input.vector_variable_size(variables_name.c_str()); v++)
+      vars.push_back(system.variable_number(input(variables_name.c_str(), "", v)));
+    if (vars.empty())
+      for (unsigned int v=0; v<system.n_vars(); v++)
+        vars.push_back(v);
+
+    for (unsigned int v=0; v<vars.size(); v++)
+    {
+      const FEType fe_type = dof_map.variable_type(vars[v]);
+      if (v == 0)
+        probe.reference_point = FEInterface::inverse_map(dim, fe_type, probe.elem, probe.point);
+
+      ProbeValue value;
+      value.name = probe.name + ":" + system.variable_name(vars[v]);
+      dof_map.dof_indices (probe.elem, value.dof_indices, vars[v]);
+      for (unsigned int i=0; i<value.dof_indices.size(); i++)
+        value.phi.push_back(FEInterface::shape(dim, fe_type, probe.elem, i, probe.reference_point));
+
+      probe.values.push_back(value);
+      probe_set.n_values++;
+    }
+
+    probe_set.probes.push_back(probe);
+  }
+
+  if (probe_set.probes.empty())
+  {
+    std::cerr<<"No probes in "<< probe_file <<std::endl;
+    libmesh_error();
+  }
+
+  std::cout<<"Probes from "<< probe_file <<" \n";
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  probe_set.file.open(file_name.c_str());
+  probe_set.file << std::setprecision(10);
+  for (unsigned int k=0; k<probe_set.probes.size(); k++)
+  {
+    const Probe& probe = probe_set.probes[k];
+    probe_set.file << "% " << probe.name << " point " << probe.point(0) << " " << probe.point(1) << " " << probe.point(2)
+      << " elem " << probe.elem->id() << " reference " << probe.reference_point(0) << " " << probe.reference_point(1) << " " << probe.reference_point(2) << "\n";
+  }
+  probe_set.file << "time";
+  for (unsigned int k=0; k<probe_set.probes.size(); k++)
+    for (unsigned int v=0; v<probe_set.probes[k].values.size(); v++)
+      probe_set.file << " " << probe_set.probes[k].values[v].name;
+  probe_set.file << "\n";
+}
+
+
+// Appends the probe values of the current solution at "time"
+void write_probes (EquationSystems& es, const Real time)
+{
+  if (probe_set.probes.empty())
+    return;
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  // Every value is evaluated by one processor, the others add zero
+  std::vector<Real> values(probe_set.n_values, 0.);
+  unsigned int n = 0;
+  for (unsigned int k=0; k<probe_set.probes.size(); k++)
+  {
+    const Probe& probe = probe_set.probes[k];
+    const bool local = (probe.elem->processor_id() == libMesh::processor_id());
+    for (unsigned int v=0; v<probe.values.size(); v++, n++)
+      if (local)
+        for (unsigned int i=0; i<probe.values[v].phi.size(); i++)
+          values[n] += probe.values[v].phi[i]*libmesh_real(system.current_solution(probe.values[v].dof_indices[i]));
+  }
+  Parallel::sum(values);
+
+  if (libMesh::processor_id() != 0)
+    return;
+
+  probe_set.file << time;
+  for (unsigned int i=0; i<values.size(); i++)
+    probe_set.file << " " << values[i];
+  probe_set.file << "\n";
+  probe_set.file.flush();
+}
+
+
+void close_probes ()
+{
+  if (probe_set.probes.empty() || (libMesh::processor_id() != 0))
+    return;
+
+  probe_set.file.close();
+}
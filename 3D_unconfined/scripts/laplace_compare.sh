@@ -0,0 +1,29 @@
+#!/bin/bash
+# Backward Euler time stepping and the Laplace domain solve at the same
+# times, both with the probes of probes.in, then
+# matlab_files/compare_laplace.m prints their errors against the Bessel
+# solution of unconfined_main.m.
+#
+#   scripts/laplace_compare.sh [n_procs] [talbot_points]
+
+NP=${1:-4}
+M=${2:-16}
+NT=20
+NE=5
+
+exe_filename="./ex11-opt"
+data_dir="data/laplace_compare/"
+mkdir -p $data_dir
+f_prefix=$data_dir"cylinder_728sym_"$NT"NT_10T"
+
+exe_str="mpirun -np $NP $exe_filename $NT $NE $f_prefix"_be" -probe_file probes.in"
+echo $exe_str
+time $exe_str > $f_prefix"_be.log"
+
+# The Laplace run writes result_file_name + "_laplace_probes.dat"
+exe_str="mpirun -np $NP $exe_filename $NT $NE $f_prefix -probe_file probes.in -laplace_times steps -talbot_points $M"
+echo $exe_str
+time $exe_str > $f_prefix"_laplace.log"
+
+cd matlab_files
+matlab -nodisplay -nosplash -r "compare_laplace; exit"
@@ -0,0 +1,30 @@
+#!/bin/bash
+# Bytes and wall time per written step of the Exodus, XDMF and Tecplot
+# output paths, from the costs output_writer.cpp reports at close_output.
+# Build with WRITE_TEC 1 and WRITE_XDMF 1 in assemble.h so all three paths
+# write the same steps.  -output_queue 0 writes in the main thread, so the
+# times are not overlapped with the solve; the XDMF path is also run with
+# single precision values.
+#
+#   scripts/output_costs.sh [n_timesteps]
+
+NT=${1:-20}
+NE=5
+
+exe_filename="./ex11-opt"
+data_dir="data/output_costs/"
+mkdir -p $data_dir
+
+for precision in 8 4
+do
+  f_prefix=$data_dir"cylinder_728sym_"$NT"NT_prec"$precision
+
+  exe_str="$exe_filename $NT $NE $f_prefix -output_queue 0 -output_precision $precision"
+  echo $exe_str
+  $exe_str > $f_prefix".log"
+
+  echo "precision $precision"
+  grep "^Output " $f_prefix".log"
+  du -b $f_prefix".e" $f_prefix".bin" $f_prefix".xmf" | awk '{ print "  " $2 " " $1 " bytes" }'
+  du -cb $f_prefix"_"*.tec | tail -1 | awk '{ print "  tecplot " $1 " bytes" }'
+done
@@ -0,0 +1,54 @@
+#!/bin/bash
+# Fixed backward Euler steps against the adaptive steps of -dt_tol, all
+# with the probes of probes.in.  For every run the number of steps (from
+# the .meta file) and the largest probe difference to a fine fixed step
+# reference, interpolated linearly to the run's times, are printed.  The
+# adaptive runs should reach the error of the fixed runs in fewer steps,
+# mostly by taking large steps once the pressure has decayed.
+#
+#   scripts/time_adaptivity.sh [n_procs]
+
+NP=${1:-4}
+NE=5
+NT_REF=400
+
+exe_filename="./ex11-opt"
+data_dir="data/time_adaptivity/"
+mkdir -p $data_dir
+f_prefix=$data_dir"cylinder_728sym_10T"
+
+run () {
+  exe_str="mpirun -np $NP $exe_filename $1 $NE $f_prefix"_"$2" -probe_file probes.in $3"
+  echo $exe_str
+  $exe_str > $f_prefix"_"$2".log"
+}
+
+# Largest |u - u_ref| over all probe values and output times of $1
+probe_error () {
+  awk 'FNR == 1 { file++ }
+       /^%/ || /^time/ { next }
+       file == 1 { n++; t[n] = $1; for (i=2; i<=NF; i++) v[n,i] = $i; next }
+       { k = 1; while ((k < n-1) && (t[k+1] < $1)) k++;
+         w = ($1-t[k])/(t[k+1]-t[k]);
+         for (i=2; i<=NF; i++) { d = $i - ((1-w)*v[k,i] + w*v[k+1,i]); if (d < 0) d = -d; if (d > e) e = d } }
+       END { print e }' $f_prefix"_ref_probes.dat" $f_prefix"_"$1"_probes.dat"
+}
+
+run $NT_REF ref ""
+
+for NT in 20 50 100
+do
+  run $NT "fixed"$NT ""
+done
+
+for TOL in 1e-2 3e-3 1e-3
+do
+  run 20 "adaptive"$TOL "-dt_tol $TOL"
+done
+
+for name in fixed20 fixed50 fixed100 adaptive1e-2 adaptive3e-3 adaptive1e-3
+do
+  steps=`grep "^steps " $f_prefix"_"$name".meta" | awk '{ print $2 }'`
+  rejected=`grep -c "^Rejected step" $f_prefix"_"$name".log"`
+  echo "$name steps $steps rejected $rejected probe error `probe_error $name`"
+done
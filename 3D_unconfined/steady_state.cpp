@@ -0,0 +1,121 @@
+#include "assemble.h"
+
+// C++ include files that we need
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "mesh.h"
+#include "equation_systems.h"
+#include "dof_map.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+#include "parallel.h"
+
+#include "assemble.h"
+
+
+// Options of the steady state monitor, off unless -steady_tol is given.
+//   -steady_tol     tolerance on the relative solution increment per unit time
+//   -steady_mode    stop: end the run, stretch: continue with larger steps
+//   -steady_stretch factor applied to dt once the tolerance is met
+void read_steady_state_options(EquationSystems& es)
+{
+  es.parameters.set<Real> ("steady_tol") = command_line_value("-steady_tol", 0.);
+  es.parameters.set<std::string> ("steady_mode") = command_line_value("-steady_mode", std::string("stop"));
+  es.parameters.set<Real> ("steady_stretch") = command_line_value("-steady_stretch", 10.);
+
+  if (es.parameters.get<Real>("steady_tol") > 0)
+    std::cout<<"steady_tol "<< es.parameters.get<Real>("steady_tol") <<" ("<< es.parameters.get<std::string>("steady_mode") <<") \n";
+}
+
+
+// ||u^{n+1}-u^n|| / (dt ||u^{n+1}||), the relative rate of change of the
+// whole solution over the last step.
+Real steady_state_increment (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const Real dt = es.parameters.get<Real>("dt");
+
+  AutoPtr<NumericVector<Number> > increment = system.current_local_solution->clone();
+  increment->add(-1., *system.old_local_solution);
+
+  const Real size = std::max(system.current_local_solution->l2_norm(), 1.e-12);
+
+  return increment->l2_norm()/(dt*size);
+}
+
+
+// Largest pore pressure magnitude, its decay shows the consolidation.
+Real max_pressure (EquationSystems& es,
+                      const std::string& system_name)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  const MeshBase& mesh = es.get_mesh();
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const unsigned int p_var = system.variable_number ("s_p");
+  const DofMap & dof_map = system.get_dof_map();
+  std::vector<unsigned int> dof_indices_p;
+
+  Real p_max = 0.;
+
+  MeshBase::const_element_iterator       el     = mesh.active_local_elements_begin();
+  const MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+
+  for ( ; el != end_el; ++el)
+  {
+    dof_map.dof_indices (*el, dof_indices_p, p_var);
+    for (unsigned int i=0; i<dof_indices_p.size(); i++)
+      p_max = std::max(p_max, std::abs(libmesh_real(system.current_solution(dof_indices_p[i]))));
+  }
+  Parallel::max(p_max);
+
+  return p_max;
+}
+
+
+// Write where (and why) the run stopped next to the result files.
+void write_run_metadata (EquationSystems& es, const std::string& result_file_name,
+                      const std::string& stop_reason, const unsigned int t_step, const Real time,
+                      const Real increment, const Real p_max)
+{
+  if (libMesh::processor_id() != 0)
+    return;
+
+  std::stringstream file_name;
+  file_name << result_file_name << ".meta";
+
+  std::ofstream meta(file_name.str().c_str());
+  meta << "stop_reason " << stop_reason << "\n";
+  meta << "steps " << t_step << "\n";
+  meta << "time " << time << "\n";
+  meta << "end_time " << es.parameters.get<Real>("end_time") << "\n";
+  meta << "dt " << es.parameters.get<Real>("dt") << "\n";
+  meta << "dt_tol " << es.parameters.get<Real>("dt_tol") << "\n";
+  meta << "increment " << increment << "\n";
+  meta << "p_max " << p_max << "\n";
+  meta << "steady_tol " << es.parameters.get<Real>("steady_tol") << "\n";
+  meta << "steady_mode " << es.parameters.get<std::string>("steady_mode") << "\n";
+  if (es.parameters.have_parameter<unsigned int>("steady_step"))
+  {
+    meta << "steady_step " << es.parameters.get<unsigned int>("steady_step") << "\n";
+    meta << "steady_time " << es.parameters.get<Real>("steady_time") << "\n";
+  }
+  meta.close();
+
+  std::cout<<"Wrote "<< file_name.str() <<std::endl;
+}
@@ -0,0 +1,58 @@
+// C++ include files that we need
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+// Basic include file needed for the mesh functionality.
+#include "libmesh.h"
+#include "equation_systems.h"
+#include "numeric_vector.h"
+#include "linear_implicit_system.h"
+#include "transient_system.h"
+
+#include "assemble.h"
+
+
+// Options of the adaptive time stepping, off unless -dt_tol is given.
+//   -dt_tol   tolerance on the relative local time error per step
+//   -dt_init  first step, end_time/NT by default
+//   -dt_min   smallest step, a step this small is accepted with a warning
+//   -dt_max   largest step
+void read_time_step_options(EquationSystems& es)
+{
+  const Real end_time = es.parameters.get<Real>("end_time");
+
+  es.parameters.set<Real> ("dt_tol") = command_line_value("-dt_tol", 0.);
+  es.parameters.set<Real> ("dt_init") = command_line_value("-dt_init", es.parameters.get<Real>("dt"));
+  es.parameters.set<Real> ("dt_min") = command_line_value("-dt_min", 1.e-6*end_time);
+  es.parameters.set<Real> ("dt_max") = command_line_value("-dt_max", end_time);
+
+  if (es.parameters.get<Real>("dt_tol") > 0)
+    std::cout<<"dt_tol "<< es.parameters.get<Real>("dt_tol") <<" \n";
+}
+
+
+// Local error of the last backward Euler step, relative to the solution.
+// The difference to the second order extrapolation through u^n and u^{n-1},
+//   dt/(dt+dt_old) (u^{n+1} - (1+r) u^n + r u^{n-1}),  r = dt/dt_old,
+// is dt^2/2 u'' up to higher order terms, the leading BE error.
+Real estimate_time_error (EquationSystems& es,
+                      const std::string& system_name,
+                      const Real dt, const Real dt_old)
+{
+  libmesh_assert (system_name == "Last_non_linear_soln");
+
+  TransientLinearImplicitSystem & system =
+    es.get_system<TransientLinearImplicitSystem> ("Last_non_linear_soln");
+
+  const Real ratio = dt/dt_old;
+
+  AutoPtr<NumericVector<Number> > lte = system.current_local_solution->clone();
+  lte->add(-(1.+ratio), *system.old_local_solution);
+  lte->add(ratio, *system.older_local_solution);
+  lte->scale(dt/(dt+dt_old));
+
+  const Real size = std::max(system.current_local_solution->l2_norm(), 1.e-12);
+
+  return lte->l2_norm()/size;
+}